@@ -0,0 +1,51 @@
+// A CandidateSolution holds the shortest solution found so far by
+// any of the threads or search engines working on a game.  Its move
+// count is an upper bound on the length of any solution worth 
+// looking for.  The bound is atomic so that every thread sees a new
+// one promptly.
+
+#ifndef CANDIDATESOLUTION_HPP
+#define CANDIDATESOLUTION_HPP
+
+#include "Game.hpp"         // for Moves
+#include <atomic>
+#include <mutex>
+
+namespace KSolveNames {
+
+class CandidateSolution
+{
+private:
+    Moves _sol;
+    std::atomic<unsigned> _count {-1U};
+    std::mutex _mutex;
+public:
+    // Call only when no thread can be changing the solution
+    const Moves & GetMoves() const noexcept
+    {
+        return _sol;
+    }
+    // Returns the move count of the solution, or -1U if there is none
+    unsigned MoveCount() const noexcept{
+        return _count.load(std::memory_order_relaxed);
+    }
+    // Returns true if source replaced the stored solution
+    template <class Container>
+    bool ReplaceIfShorter(const Container& source, unsigned count) noexcept
+    {
+        if (count < MoveCount()){
+            std::lock_guard<std::mutex> nikita(_mutex);
+            if (count < MoveCount()){
+                _sol.assign(source.begin(), source.end());
+                _count.store(count, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+    bool IsEmpty() const noexcept {return MoveCount() == -1U;}
+};
+
+}   // namespace KSolveNames
+
+#endif  // CANDIDATESOLUTION_HPP
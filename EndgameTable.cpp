@@ -0,0 +1,283 @@
+// EndgameTable.cpp implements the EndgameTable class.
+
+#include "EndgameTable.hpp"
+#include "KSolveAStar.hpp"          // for MinimumMovesLeft
+#include "GameStateMemory.hpp"      // for GameState, Hasher
+#include <algorithm>
+#include <cstring>                  // for std::memcpy
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace KSolveNames {
+
+namespace {
+// Identifies files written by EndgameTable::Save()
+const char FileTag[] = "KSEG";
+constexpr std::uint8_t FileVersion = 1;
+// Marks face-up tableau cards in a key
+constexpr std::uint8_t FaceUp = 0x40;
+// Stands for EndgameTable::Unwinnable in the table and in files
+constexpr std::uint16_t StoredUnwinnable = 0xffff;
+
+unsigned CardsLeft(const Game& game) noexcept
+{
+    unsigned onFoundation = 0;
+    for (const Pile& pile: game.Foundation())
+        onFoundation += pile.size();
+    return CardsPerDeck - onFoundation;
+}
+}   // namespace
+
+EndgameTable::EndgameTable(unsigned maxCards, unsigned maxExpansions) noexcept
+    : _maxCards(std::min(maxCards, MaxCardsLimit))
+    , _maxExpansions(maxExpansions)
+    {}
+
+size_t EndgameTable::KeyHasher::operator() (const Key& key) const noexcept
+{
+    std::uint64_t words[sizeof(Key)/8];
+    std::memcpy(words, key.data(), sizeof(Key));
+    std::uint64_t result = 0;
+    for (std::uint64_t word: words)
+        result = (result ^ word) * 0x9e3779b97f4a7c15ULL;
+    return result ^ result >> 29;
+}
+
+// The key lists the draw setting, the recycles left, the sizes of the
+// stock and waste piles, and their cards.  Then, for each tableau pile
+// that is not empty, it lists its size and its cards, marking those
+// face up.  The tableau piles are sorted by those lists.  Cards on
+// the foundation are those not listed.
+EndgameTable::Key EndgameTable::MakeKey(const Game& game) noexcept
+{
+    Key key{};
+    unsigned n = 0;
+    key[n++] = game.DrawSetting();
+    key[n++] = std::min(game.RecycleLimit() - game.RecycleCount(), 255U);
+    key[n++] = game.StockPile().size();
+    key[n++] = game.WastePile().size();
+    for (const Card card: game.StockPile())
+        key[n++] = card.Value();
+    for (const Card card: game.WastePile())
+        key[n++] = card.Value();
+
+    // Each pile's size, then its cards, then zeros
+    using PileBytes = std::array<std::uint8_t,MaxCardsLimit+1>;
+    std::array<PileBytes,TableauSize> piles{};
+    for (unsigned p = 0; p < TableauSize; ++p) {
+        const Pile& pile = game.Tableau()[p];
+        piles[p][0] = pile.size();
+        const unsigned downCount = pile.size() - pile.UpCount();
+        for (unsigned i = 0; i < pile.size(); ++i)
+            piles[p][i+1] = pile[i].Value() | (i < downCount ? 0 : FaceUp);
+    }
+    std::sort(piles.begin(), piles.end());
+    for (const PileBytes& bytes: piles) {
+        if (bytes[0] == 0) continue;        // empty pile
+        const unsigned length = bytes[0] + 1;
+        assert(n + length <= key.size());
+        std::copy(bytes.begin(), bytes.begin()+length, key.begin()+n);
+        n += length;
+    }
+    return key;
+}
+
+bool EndgameTable::Covers(const Game& game) const noexcept
+{
+    return CardsLeft(game) <= _maxCards;
+}
+
+unsigned EndgameTable::Probe(const Game& game) const noexcept
+{
+    if (!Covers(game)) return 0;
+    const Key key = MakeKey(game);
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    const auto it = _distances.find(key);
+    if (it == _distances.end()) return 0;
+    return it->second == StoredUnwinnable ? Unwinnable : it->second;
+}
+
+void EndgameTable::Record(const Game& game, unsigned distance) noexcept
+{
+    const Key key = MakeKey(game);
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _distances[key] = distance == Unwinnable ? StoredUnwinnable : distance;
+}
+
+bool EndgameTable::GaveUp(const Game& game) const noexcept
+{
+    const Key key = MakeKey(game);
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _gaveUp.contains(key);
+}
+
+size_t EndgameTable::Size() const noexcept
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _distances.size();
+}
+
+// Builds a shortest finish from game, which is known to be distance
+// moves from a win, by stepping at each position to a child the table
+// knows to be that much nearer.  Returns false if no such child is
+// found (AvailableMoves() may have left it out).
+bool EndgameTable::FollowTable(const Game& game, unsigned distance, 
+                               Moves& finish) const noexcept
+{
+    Game position(game);
+    MoveCounter<Moves> path;
+    path.clear();
+    while (distance) {
+        bool stepped = false;
+        for (auto mv: position.AvailableMoves(path)) {
+            if (mv.NMoves() > distance) continue;
+            const unsigned left = distance - mv.NMoves();
+            position.MakeMove(mv);
+            if (left ? Probe(position) == left : position.GameOver()) {
+                path.push_back(mv);
+                distance = left;
+                stepped = true;
+                break;
+            }
+            position.UnMakeMove(mv);
+        }
+        if (!stepped) return false;
+    }
+    finish.assign(path.begin(), path.end());
+    return true;
+}
+
+// If the table knows the distance from game, follow it.  If not, an
+// A* search from game, with the distances already in the table
+// raising MinimumMovesLeft() where they are known.
+EndgameOutcome EndgameTable::Finish(const Game& game, Moves& finish) noexcept
+{
+    if (!Covers(game)) return EndgameUnknown;
+    const unsigned known = Probe(game);
+    if (known == Unwinnable) return EndgameLoss;
+    if (known && FollowTable(game, known, finish)) return EndgameWin;
+    if (GaveUp(game)) return EndgameUnknown;
+
+    struct Leaf {
+        unsigned _minMoves;
+        unsigned _made;
+        unsigned _path;         // index in paths
+        // Lowest minimum moves first, then most moves made
+        bool operator<(const Leaf& other) const noexcept
+        {
+            return _minMoves > other._minMoves
+                || (_minMoves == other._minMoves && _made < other._made);
+        }
+    };
+    std::vector<MoveCounter<Moves>> paths(1);
+    paths[0].clear();
+    std::priority_queue<Leaf> fringe;
+    fringe.push({MinimumMovesLeft(game), 0, 0});
+    // The shortest path found to each state
+    std::unordered_set<GameState,Hasher> closed;
+    closed.insert(GameState{game, 0});
+
+    for (unsigned expansions = 0; fringe.size(); ++expansions) {
+        const Leaf leaf = fringe.top();
+        fringe.pop();
+        Game position(game);
+        for (auto mv: paths[leaf._path])
+            position.MakeMove(mv);
+        if (position.GameOver()) {
+            const auto& path = paths[leaf._path];
+            finish.assign(path.begin(), path.end());
+            // Every position on a shortest path is itself that far
+            // from its shortest finish.
+            Game step(game);
+            unsigned made = 0;
+            Record(step, leaf._made);
+            for (auto mv: finish) {
+                step.MakeMove(mv);
+                made += mv.NMoves();
+                if (Covers(step)) Record(step, leaf._made - made);
+            }
+            return EndgameWin;
+        }
+        if (expansions == _maxExpansions) {
+            const Key key = MakeKey(game);
+            std::unique_lock<std::shared_mutex> lock(_mutex);
+            _gaveUp.insert(key);
+            return EndgameUnknown;
+        }
+
+        const QMoves avail = position.AvailableMoves(paths[leaf._path]);
+        for (auto mv: avail) {
+            position.MakeMove(mv);
+            const unsigned made = leaf._made + mv.NMoves();
+            const GameState state{position, made};
+            auto [it, inserted] = closed.insert(state);
+            bool shorter = inserted;
+            if (!inserted && made < it->MoveCount()) {
+                closed.erase(it);
+                closed.insert(state);
+                shorter = true;
+            }
+            const unsigned known = shorter ? Probe(position) : 0;
+            if (shorter && known != Unwinnable) {
+                const unsigned left = std::max(MinimumMovesLeft(position), known);
+                paths.push_back(paths[leaf._path]);
+                paths.back().push_back(mv);
+                fringe.push({made + left, made, unsigned(paths.size()-1)});
+            }
+            position.UnMakeMove(mv);
+        }
+    }
+    // The search ran dry, so no finish exists.
+    Record(game, Unwinnable);
+    return EndgameLoss;
+}
+
+// The file holds FileTag, FileVersion, the number of entries as
+// eight bytes, and the entries.  Each entry is a key followed by
+// its distance as two bytes.  Numbers are stored low byte first.
+bool EndgameTable::Save(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    file.write(FileTag, 4);
+    file.put(char(FileVersion));
+    const std::uint64_t count = _distances.size();
+    for (unsigned i = 0; i < 8; ++i)
+        file.put(char(count >> 8*i));
+    for (const auto& [key, distance]: _distances) {
+        file.write(reinterpret_cast<const char*>(key.data()), key.size());
+        file.put(char(distance));
+        file.put(char(distance >> 8));
+    }
+    return bool(file);
+}
+
+bool EndgameTable::Load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char tag[4];
+    if (!file.read(tag, 4) || !std::equal(tag, tag+4, FileTag)) return false;
+    if (file.get() != FileVersion) return false;
+    std::uint8_t bytes[sizeof(Key)+2];
+    if (!file.read(reinterpret_cast<char*>(bytes), 8)) return false;
+    std::uint64_t count = 0;
+    for (unsigned i = 0; i < 8; ++i)
+        count |= std::uint64_t(bytes[i]) << 8*i;
+    // Read everything before adding any of it, so a bad file adds nothing.
+    std::vector<std::pair<Key,std::uint16_t>> entries;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (!file.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) return false;
+        Key key;
+        std::copy(bytes, bytes+sizeof(Key), key.begin());
+        entries.emplace_back(key, bytes[sizeof(Key)] | bytes[sizeof(Key)+1] << 8);
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    for (const auto& [key, distance]: entries)
+        _distances[key] = distance;
+    return true;
+}
+
+}   // namespace KSolveNames
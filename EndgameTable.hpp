@@ -0,0 +1,87 @@
+// An EndgameTable records the exact number of moves needed to win
+// from game positions with few cards left off the foundation.  It
+// fills itself lazily: asked to finish a position it does not know,
+// it searches for the shortest finish and records the distance of
+// every position along it.  A table can be saved to a file and loaded
+// again, so one built while solving many deals (see
+// tools/BuildEndgameTable.cpp) can help solve others.
+//
+// Positions are keyed by the cards left and where they lie, not by
+// the deal, and tableau piles are keyed without regard to order.
+//
+// Instances are thread-safe.
+
+#ifndef ENDGAMETABLE_HPP
+#define ENDGAMETABLE_HPP
+
+#include "Game.hpp"             // for Game, Moves
+#include <array>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace KSolveNames {
+
+enum EndgameOutcome {EndgameWin, EndgameLoss, EndgameUnknown};
+
+class EndgameTable
+{
+public:
+    // The most cards off the foundation a table can cover
+    static constexpr unsigned MaxCardsLimit = 20;
+    // Returned by Probe() for positions that cannot be won
+    static constexpr unsigned Unwinnable = -1U;
+
+    // Covers positions with at most maxCards cards (up to
+    // MaxCardsLimit) not on the foundation.  A search for a finish
+    // gives up after maxExpansions expansions.
+    explicit EndgameTable(unsigned maxCards = MaxCardsLimit,
+                          unsigned maxExpansions = 20'000) noexcept;
+
+    unsigned MaxCards() const noexcept {return _maxCards;}
+    // Returns true if game has few enough cards left to be covered
+    bool Covers(const Game& game) const noexcept;
+    // Returns the number of moves needed to win from game if known,
+    // Unwinnable if game is known to be lost, and 0 otherwise.
+    unsigned Probe(const Game& game) const noexcept;
+    // If game is covered and a shortest finish can be found, put it
+    // in finish and return EndgameWin.  If game is covered and
+    // cannot be won, return EndgameLoss.  Otherwise, return
+    // EndgameUnknown.  A position whose search gave up is not
+    // searched again.
+    EndgameOutcome Finish(const Game& game, Moves& finish) noexcept;
+    // Returns the number of positions recorded
+    size_t Size() const noexcept;
+
+    // Add the positions recorded in a file written by Save() to this
+    // table.  Returns false, adding nothing, if the file cannot be
+    // read or is not in the format Save() writes.
+    bool Load(const std::string& path);
+    // Write the positions recorded to a file.  Returns false on failure.
+    bool Save(const std::string& path) const;
+
+private:
+    // A canonical form of a position.  See MakeKey() in EndgameTable.cpp.
+    using Key = std::array<std::uint8_t,32>;
+    struct KeyHasher
+    {
+        size_t operator() (const Key& key) const noexcept;
+    };
+    unsigned _maxCards;
+    unsigned _maxExpansions;
+    mutable std::shared_mutex _mutex;
+    std::unordered_map<Key,std::uint16_t,KeyHasher> _distances;
+    // Positions whose search gave up.  These are not saved.
+    std::unordered_set<Key,KeyHasher> _gaveUp;
+
+    static Key MakeKey(const Game& game) noexcept;
+    void Record(const Game& game, unsigned distance) noexcept;
+    bool GaveUp(const Game& game) const noexcept;
+    bool FollowTable(const Game& game, unsigned distance, Moves& finish) const noexcept;
+};
+
+}   // namespace KSolveNames
+
+#endif  // ENDGAMETABLE_HPP
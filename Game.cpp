@@ -133,6 +133,7 @@ namespace KSolveNames {
 		, _kingSpaces(orig._kingSpaces)
 		, _tableau(orig._tableau)
 		, _foundation(orig._foundation)
+		, _talonSet(orig._talonSet)
 	{
 	}
 
@@ -156,6 +157,9 @@ namespace KSolveNames {
 		}
 		// Deal last 24 cards to stock, reversing order
 		_stock.assign(_deck.crbegin(), _deck.crbegin() + 24);
+		_talonSet = 0;
+		for (const Card card : _stock)
+			_talonSet |= std::uint64_t(1) << card.Value();
 	}
 
 	void Game::MakeMove(MoveSpec mv) noexcept
@@ -166,6 +170,7 @@ namespace KSolveNames {
 			_waste.Draw(_stock, mv.DrawCount());
 			toPile.Push(_waste.Pop());
 			toPile.IncrUpCount(1);
+			_talonSet &= ~(std::uint64_t(1) << toPile.back().Value());
 			_recycleCount += mv.Recycle();
 		}
 		else {
@@ -174,6 +179,9 @@ namespace KSolveNames {
 			const auto isLadderMove{ mv.IsLadderMove() };
 			toPile.Take(fromPile, n);
 			assert(!(fromPile.IsTableau() && fromPile.UpCount() != mv.FromUpCount()));
+			if (fromPile.Code() == Waste) {
+				_talonSet &= ~(std::uint64_t(1) << toPile.back().Value());
+			}
 			if (isLadderMove) {
 				_foundation[mv.LadderSuit()].Draw(fromPile);
 			}
@@ -196,6 +204,7 @@ namespace KSolveNames {
 		Pile& toPile = AllPiles()[to];
 		if (mv.IsStockMove()) {
 			_waste.Push(toPile.Pop());
+			_talonSet |= std::uint64_t(1) << _waste.back().Value();
 			toPile.IncrUpCount(-1);
 			_stock.Draw(_waste, mv.DrawCount());
 			if (mv.Recycle()) --_recycleCount;
@@ -216,6 +225,9 @@ namespace KSolveNames {
 			}
 			fromPile.Take(toPile, n);
 			toPile.IncrUpCount(-static_cast<int32_t>(n));
+			if (fromPile.Code() == Waste) {
+				_talonSet |= std::uint64_t(1) << fromPile.back().Value();
+			}
 		}
 	}
 
@@ -231,6 +243,10 @@ namespace KSolveNames {
 			toPile.Draw(fromPile, n);
 		else
 			toPile.Take(fromPile, n);
+		if (from == Waste && to != Stock) {
+			for (auto i = toPile.end() - n; i != toPile.end(); ++i)
+				_talonSet &= ~(std::uint64_t(1) << i->Value());
+		}
 		if (fromPile.empty() && fromPile.IsTableau())
 			_kingSpaces += 1;
 		toPile.IncrUpCount(n);
@@ -247,6 +263,44 @@ namespace KSolveNames {
 			[&](const auto& pile) {return pile.size() == CardsPerSuit;});
 	}
 
+	bool Game::IsTrivialFinish() const noexcept
+	{
+		return _stock.empty() && _waste.empty()
+			&& std::all_of(_tableau.cbegin(), _tableau.cend(),
+				[](const auto& pile) {return pile.UpCount() == pile.size();});
+	}
+
+	// Every pile is a run from its base down, so its top card is
+	// its lowest.  The lowest top card in the tableau is then the
+	// lowest card of its suit not on the foundation, and it can go
+	// there.  Repeat until the tableau is empty.
+	Moves Game::TrivialFinish() const
+	{
+		assert(IsTrivialFinish());
+		std::array<unsigned,TableauSize> sizes;
+		unsigned cardsLeft = 0;
+		for (unsigned i = 0; i < TableauSize; ++i) {
+			sizes[i] = _tableau[i].size();
+			cardsLeft += sizes[i];
+		}
+		Moves result;
+		result.reserve(cardsLeft);
+		for (; cardsLeft; --cardsLeft) {
+			unsigned lowest = TableauSize;
+			for (unsigned i = 0; i < TableauSize; ++i) {
+				if (sizes[i] && (lowest == TableauSize 
+						|| _tableau[i][sizes[i]-1].Rank() 
+							< _tableau[lowest][sizes[lowest]-1].Rank()))
+					lowest = i;
+			}
+			const Card card = _tableau[lowest][sizes[lowest]-1];
+			result.push_back(NonStockMove(PileCodeT(TableauBase+lowest),
+				FoundationPileCode(card.Suit()), 1, sizes[lowest]));
+			--sizes[lowest];
+		}
+		return result;
+	}
+
 	// Return the height of the shortest foundation pile
 	unsigned Game::MinFoundationPileSize() const noexcept
 	{
@@ -373,23 +427,6 @@ namespace KSolveNames {
 		}
 	}
 
-	struct TalonFuture
-	{
-		Card _card;
-		unsigned short _nMoves;
-		signed short _drawCount;
-		bool _recycle;
-
-		TalonFuture() {};
-		TalonFuture(const Card& card, unsigned nMoves, int draw, bool recycle)
-			: _card(card)
-			, _nMoves(nMoves)
-			, _drawCount(draw)
-			, _recycle(recycle)
-		{
-		}
-	};
-
 	// Class to simulate draws and recycles of the talon and
 	// return the top card of the simulated waste pile.
 	class TalonSim
@@ -443,7 +480,9 @@ namespace KSolveNames {
 	// to reach each one.
 	//
 	// Enforces the limit on recycles
-	typedef static_vector<TalonFuture, 24> TalonFutureVec;
+	//
+	// Draw is the draw setting, or 0 to use game.DrawSetting().
+	template <unsigned Draw>
 	static TalonFutureVec TalonCards(const Game& game)
 	{
 		TalonFutureVec result;
@@ -452,7 +491,7 @@ namespace KSolveNames {
 
 		TalonSim talon(game);
 		const unsigned originalWasteSize = talon.WasteSize();
-		const unsigned drawSetting = game.DrawSetting();
+		const unsigned drawSetting = Draw ? Draw : game.DrawSetting();
 		unsigned nMoves = 0;
 		unsigned nRecycles = 0;
 		unsigned maxRecycles = std::min(1U, game.RecycleLimit() - game.RecycleCount());
@@ -476,13 +515,29 @@ namespace KSolveNames {
 		return result;
 	}
 
+	// Return TalonCards(*this), computing it only if the talon has
+	// changed since the last call.  The common draw settings get
+	// their own instances of TalonCards().
+	const TalonFutureVec& Game::TalonFutures() const noexcept
+	{
+		const TalonKey key{ _talonSet, static_cast<unsigned char>(_waste.size()), _recycleCount };
+		if (key != _talonKey) {
+			switch (_drawSetting) {
+			case 1:  _talonFutures = TalonCards<1>(*this); break;
+			case 3:  _talonFutures = TalonCards<3>(*this); break;
+			default: _talonFutures = TalonCards<0>(*this); break;
+			}
+			_talonKey = key;
+		}
+		return _talonFutures;
+	}
+
 	// Append to "moves" any available moves from the talon.
 	void Game::MovesFromTalon(QMoves& moves, unsigned minFoundationSize) const noexcept
 	{
 		// Look for move from the talon to tableau or foundation, including moves that become available 
 		// after one or more draws.  
-		const TalonFutureVec talon(TalonCards(*this));
-		for (auto talonCard : talon) {
+		for (auto talonCard : TalonFutures()) {
 			bool recycle = talonCard._recycle;
 			if (CanMoveToFoundation(talonCard._card)) {
 				const auto pileNo = FoundationPileCode(talonCard._card.Suit());
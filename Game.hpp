@@ -22,6 +22,7 @@
 #include <optional>
 #include <numeric>
 #include <algorithm>
+#include <cstdint>
 
 #include "frystl/static_vector.hpp"
 namespace KSolveNames {
@@ -253,12 +254,13 @@ class MoveSpec
 // fringe), it has been made type-safe at run time using asserts.
 {
 private:
-    PileCodeT _from = PileCount;    // _from == Stock means stock MoveSpec
-    PileCodeT _to:7 = PileCount;
+    PileCodeT _from:4 = PileCount;  // _from == Stock means stock MoveSpec
+    PileCodeT _to:4 = PileCount;
     bool _flipsTopCard:1 = false;
     unsigned char _nMoves:5 = 0;
     Card::SuitT _ladderSuit :2 = Card::Clubs; 
     bool _recycle:1 = false;
+    bool _tagged:1 = false;         // not part of the move; see Tagged()
     union {
         // Non-stock MoveSpec
         struct {
@@ -316,6 +318,10 @@ public:
     bool IsLadderMove() const noexcept  {return IsTableau(_from) && _nMoves == 2;}
     bool FlipsTopCard() const noexcept  {return _flipsTopCard;}
     void FlipsTopCard(bool f) noexcept  {_flipsTopCard = f;}
+    // A bit a container of MoveSpecs may use as it sees fit.  It does 
+    // not affect the move, and operator== ignores it.
+    bool Tagged() const noexcept        {return _tagged;}
+    void Tagged(bool t) noexcept        {_tagged = t;}
 
     bool operator==(const MoveSpec rhs) const noexcept
     {
@@ -330,6 +336,7 @@ public:
 
 };
 static_assert(sizeof(MoveSpec) == 4, "MoveSpec must be 4 bytes long");
+static_assert(PileCount < 16, "PileCodeT must fit in MoveSpec's 4-bit fields");
 
 inline MoveSpec StockMove(PileCodeT to, unsigned nMoves, int draw, bool recycle) noexcept
 {
@@ -590,6 +597,28 @@ static void XYZ_Filter(V1& newMoves, const V2& movesMade)
 
 using QMoves = QMovesTemplate<43>;
 
+// A card that can be played from the talon, the number of moves 
+// (draws) needed before it can be played, the number of cards that
+// must be drawn (or undrawn) to reach it, and whether the waste
+// pile must be recycled to reach it.
+struct TalonFuture
+{
+    Card _card;
+    unsigned short _nMoves;
+    signed short _drawCount;
+    bool _recycle;
+
+    TalonFuture() {};
+    TalonFuture(const Card& card, unsigned nMoves, int draw, bool recycle)
+        : _card(card)
+        , _nMoves(nMoves)
+        , _drawCount(draw)
+        , _recycle(recycle)
+    {
+    }
+};
+typedef static_vector<TalonFuture, 24> TalonFutureVec;
+
 class Game
 {
 public:
@@ -611,6 +640,22 @@ private:
     using MoveCacheType = QMovesTemplate<9>;
     mutable MoveCacheType _domMovesCache;
 
+    // The cards in the stock and waste piles, one bit per Card::Value()
+    std::uint64_t   _talonSet;
+    // Draws and recycles keep the order of the talon, so the cards in
+    // it, the size of the waste pile, and the recycle count determine
+    // which cards can be played from it.  _talonFutures holds those
+    // for the talon described by _talonKey.
+    struct TalonKey
+    {
+        std::uint64_t _talonSet;
+        unsigned char _wasteSize;
+        unsigned char _recycleCount;
+        bool operator==(const TalonKey&) const noexcept = default;
+    };
+    mutable TalonKey _talonKey{0, 0xff, 0};     // matches no talon
+    mutable TalonFutureVec _talonFutures;
+
     // Return true if any more empty columns are needed for kings
     bool NeedKingSpace() const noexcept {return _kingSpaces < SuitsPerDeck;}
 
@@ -621,6 +666,7 @@ private:
     void MovesFromTableau(QMoves & moves) const noexcept;
     void MovesFromTalon(QMoves & moves, unsigned minFndSize) const noexcept;
     void MovesFromFoundation(QMoves & moves, unsigned minFndSize) const noexcept;
+    const TalonFutureVec& TalonFutures() const noexcept;
 
     std::array<Pile,PileCount>& AllPiles() {
         return *reinterpret_cast<std::array<Pile,PileCount>* >(&_waste);
@@ -654,6 +700,12 @@ public:
     bool        IsValid(XMove xmv) const noexcept;
     unsigned    MinFoundationPileSize() const noexcept;
     bool        GameOver() const noexcept;
+    // Returns true if the talon is empty and every card in the tableau
+    // is face up.  Such a game can be won with one move per card left.
+    bool        IsTrivialFinish() const noexcept;
+    // Returns the moves that win a game for which IsTrivialFinish()
+    // is true in the fewest moves.
+    Moves       TrivialFinish() const;
 
     // Return a vector of the available moves that pass the XYZ_Move filter.
     // Dominant moves are returned one at a time; others, all at once.
@@ -688,8 +740,7 @@ void TestSolution(Game game, const Container& moves)
     game.Deal();
     // PrintGame(game);
     for (auto mv: moves) {
-        bool valid = game.IsValid(mv);
-        assert(valid);
+        assert(game.IsValid(mv));
         game.MakeMove(mv);
     }
     // PrintGame(game);
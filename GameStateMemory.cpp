@@ -1,12 +1,26 @@
 // GameStateMemory.cpp implements the GameStateMemory class.
 
 #include <algorithm>        // max
+#include <atomic>
+#include <bit>              // bit_width
+#include <shared_mutex>
+#include <thread>           // yield
+#include <unordered_set>
 #include "GameStateMemory.hpp"
+#include "SpillFile.hpp"
+#include "parallel_hashmap/phmap.h"     // for parallel_flat_hash_set
 
 namespace KSolveNames {
 
-// 32 bytes --> 21 bits
-static inline uint32_t DeflateTableau(const Pile& cards) noexcept
+// Number of distinct codes TableauCode() can return for one suit
+// of top card
+static constexpr unsigned CodesPerSuit = (1U<<CardsPerSuit) - CardsPerSuit;
+// Number of distinct codes TableauCode() can return
+static constexpr unsigned TableauCodeCount = 1 + SuitsPerDeck*CodesPerSuit;
+static_assert(TableauCodeCount < 1U<<15);
+
+// 32 bytes --> 15 bits
+static inline uint32_t TableauCode(const Pile& cards) noexcept
 {
     uint32_t result {0};
     const unsigned upCount = cards.UpCount();
@@ -17,70 +31,607 @@ static inline uint32_t DeflateTableau(const Pile& cards) noexcept
         // and whether each other face-up card is from 
         // a major suit (hearts or spades) or not.
         //
-        // The face-up cards in a tableau pile cannot number
-        // more than 12, since AvailableMoves() will never move an
-        // ace there.
+        // AvailableMoves() never moves an ace to the tableau, and
+        // nothing can cover an ace there, so an ace is always alone,
+        // and the face-up cards on a top card of rank r (counting
+        // from zero) number at most r.  Counting (top card, upCount, 
+        // isMajor) triples for a single suit with that in mind
+        // gives 1 for an ace and 2^r-1 for higher ranks.  Their
+        // sum is CodesPerSuit.
         unsigned isMajor = 
             std::accumulate(cards.end()-upCount+1, cards.end(), 0,
                 [](unsigned acc, Card card)
                     {return acc<<1 | card.IsMajor();});
         const Card top = cards.Top();
-        result =  ((top.Suit()
-                    <<4  | top.Rank())
-                    <<11 | isMajor)
-                    <<4  | upCount;
+        const unsigned rank = top.Rank();
+        assert(upCount == 1 || upCount <= rank);
+        const unsigned rankOffset = rank ? (1U<<rank) - rank : 0;
+        result =  1 + top.Suit()*CodesPerSuit + rankOffset
+                + (1U<<(upCount-1)) - 1 + isMajor;
     }
     return result;
 }
+
+namespace {
+// Just enough of an unsigned 128-bit integer to compute the 
+// rank of a sorted tableau
+struct UInt128
+{
+    std::uint64_t _lo {0};
+    std::uint64_t _hi {0};
+    UInt128& operator+=(const UInt128& other) noexcept
+    {
+        _lo += other._lo;
+        _hi += other._hi + (_lo < other._lo);
+        return *this;
+    }
+};
+
+// Table of the binomial coefficients C(n,k) for 0 <= k <= TableauSize
+// and 0 <= n < TableauCodeCount+TableauSize-1.
+class Binomials
+{
+    using RowType = std::array<UInt128,TableauSize+1>;
+    std::vector<RowType> _rows;
+public:
+    Binomials()
+        : _rows(TableauCodeCount+TableauSize-1)
+    {
+        // Pascal's triangle
+        _rows[0][0]._lo = 1;
+        for (unsigned n = 1; n < _rows.size(); ++n) {
+            _rows[n][0]._lo = 1;
+            for (unsigned k = 1; k <= TableauSize; ++k) {
+                _rows[n][k] = _rows[n-1][k-1];
+                _rows[n][k] += _rows[n-1][k];
+            }
+        }
+    }
+    const UInt128& operator()(unsigned n, unsigned k) const noexcept
+    {
+        return _rows[n][k];
+    }
+};
+}   // namespace
+
+// Return the rank of a sorted list of tableau codes among
+// all such lists in the combinatorial number system.  The
+// result is less than 2^93.
+static UInt128 TableauRank(const std::array<uint32_t,TableauSize>& codes) noexcept
+{
+    static const Binomials binomial;
+    UInt128 result;
+    for (unsigned i = 0; i < TableauSize; ++i) {
+        // codes[i]+i is strictly increasing
+        result += binomial(codes[i]+i, i+1);
+    }
+    return result;
+}
+
 GameState::GameState(const Game& game, unsigned moveCount) noexcept
     : _moveCount(moveCount)
 {
+    assert(moveCount < 1U<<15);
     std::array<uint32_t,TableauSize> tableauState;
     const auto& tableau = game.Tableau();
     for (unsigned i = 0; i<TableauSize; ++i) {
-        tableauState[i] = DeflateTableau(tableau[i]);
+        tableauState[i] = TableauCode(tableau[i]);
     }
     // Sort the tableau states because tableaus that are identical
     // except for order are considered equal
     ranges::sort(tableauState);
+    const UInt128 rank = TableauRank(tableauState);
 
-    _part0 =          (PartType(tableauState[0])
-                <<21 | PartType(tableauState[1]))
-                <<21 | PartType(tableauState[2]);
-    _part1 =          (PartType(tableauState[3])
-                <<21 | PartType(tableauState[4]))
-                <<21 | PartType(tableauState[5]);
+    // Stock size and foundation sizes in mixed radix: < 25*14^4 < 2^20
+    const unsigned radix = CardsPerSuit+1;
     auto& fnd{game.Foundation()};
-    _part2 =       ((((PartType(tableauState[6])
-                <<5  | game.StockPile().size())
-                <<4  | fnd[0].size())
-                <<4  | fnd[1].size()) 
-                <<4  | fnd[2].size()) 
-                <<4  | fnd[3].size();
+    const PartType talonAndFoundation =
+                     (((PartType(game.StockPile().size())
+                *radix + fnd[0].size())
+                *radix + fnd[1].size()) 
+                *radix + fnd[2].size()) 
+                *radix + fnd[3].size();
+
+    _part0 = rank._lo;
+    _part1 = rank._hi<<20 | talonAndFoundation;
 }
 
-GameStateMemory::GameStateMemory() noexcept
-    : _states()
+// Return a well-mixed 64-bit hash of the key of a GameState
+static inline std::uint64_t MixedHash(const GameState& state) noexcept
 {
-    _states.reserve(MinCapacity);
+    // Finalizer from splitmix64
+    std::uint64_t x = state._part0 ^ (std::uint64_t(state._part1) * 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
 }
 
-bool GameStateMemory::IsShortPathToState(const Game& game, unsigned moveCount) noexcept
+StateFingerprint::StateFingerprint(const GameState& state) noexcept
+    : _value((MixedHash(state) & ~std::uint64_t(0x7fff)) | state._moveCount)
+{
+}
+
+namespace {
+// A minimal spin lock usable as a phmap submap mutex
+class SpinLock
+{
+    std::atomic_flag _flag = ATOMIC_FLAG_INIT;
+public:
+    void lock() noexcept
+    {
+        while (_flag.test_and_set(std::memory_order_acquire)) {
+            while (_flag.test(std::memory_order_relaxed))
+                std::this_thread::yield();
+        }
+    }
+    bool try_lock() noexcept
+    {
+        return !_flag.test_and_set(std::memory_order_acquire);
+    }
+    void unlock() noexcept
+    {
+        _flag.clear(std::memory_order_release);
+    }
+};
+
+// A closed list implemented as a parallel_flat_hash_set.
+// Key may be GameState or StateFingerprint.
+template <class Key, class KeyHasher, unsigned LogSubmaps, class MutexT>
+class PhmapClosedList : public ClosedList
+{
+    typedef phmap::parallel_flat_hash_set< 
+            Key, 								// key type
+            KeyHasher,							// hash function
+            phmap::priv::hash_default_eq<Key>,  // == function
+            phmap::priv::Allocator<Key>, 
+            LogSubmaps, 						// log2(number of submaps)
+            MutexT								// mutex type
+        > SetType;
+protected:
+    SetType _states;
+public:
+    explicit PhmapClosedList(size_t minCapacity)
+    {
+        _states.reserve(minCapacity);
+    }
+    bool IsShortPathToState(const GameState& state) noexcept override
+    {
+        const Key newKey{state};
+        const unsigned moveCount = state.MoveCount();
+        if constexpr (std::is_same_v<MutexT,std::shared_mutex>) {
+            // Most calls find the state already stored with a move count
+            // no higher.  Settle those under a shared lock.
+            bool settled{false};
+            _states.if_contains(newKey, 
+                [&](const Key& oldKey) {settled = oldKey.MoveCount() <= moveCount;});
+            if (settled) return false;
+        }
+        bool valueChanged{false};
+        bool isNewKey = _states.lazy_emplace_l(
+            newKey,						// (key, value)
+            [&](Key& oldKey) {	        // run behind lock when key found
+                if (moveCount < oldKey.MoveCount()) {
+                    oldKey.SetMoveCount(moveCount);
+                    valueChanged = true;
+                }
+            },
+            [&](const typename SetType::constructor& ctor) { // ... if key not found
+                ctor(newKey);
+            }
+        );
+        return isNewKey | valueChanged;
+    }
+    size_t Size() const noexcept override
+    {
+        return _states.size();
+    }
+};
+
+// A closed list implemented as an array of std::unordered_set objects,
+// each protected by a mutex.  It is here mostly as a baseline for 
+// measuring the others.
+class ShardedStdSet : public ClosedList
+{
+    static constexpr unsigned NShards = 256;
+    struct Shard
+    {
+        std::mutex _mutex;
+        std::unordered_set<GameState,Hasher> _states;
+    };
+    std::array<Shard,NShards> _shards;
+public:
+    explicit ShardedStdSet(size_t minCapacity)
+    {
+        for (auto& shard: _shards)
+            shard._states.reserve(minCapacity/NShards);
+    }
+    bool IsShortPathToState(const GameState& state) noexcept override
+    {
+        const size_t hash = Hasher()(state);
+        Shard& shard = _shards[(hash ^ hash>>32) % NShards];
+        std::lock_guard<std::mutex> guard(shard._mutex);
+        auto [iter, isNewKey] = shard._states.insert(state);
+        if (isNewKey) return true;
+        // The move count is not part of the key, so changing it
+        // leaves the set in order.
+        GameState& oldState = const_cast<GameState&>(*iter);
+        if (state.MoveCount() < oldState.MoveCount()) {
+            oldState.SetMoveCount(state.MoveCount());
+            return true;
+        }
+        return false;
+    }
+    size_t Size() const noexcept override
+    {
+        size_t result{0};
+        for (auto& shard: _shards) 
+            result += shard._states.size();
+        return result;
+    }
+};
+
+// A closed list implemented as a fixed-size open-addressing hash
+// table with linear probing.  It uses no locks.
+//
+// Each slot holds a GameState in two atomic words.  The first holds
+// _part0.  The second, the tail, holds _part1 and the move count, so 
+// a shorter path is recorded by a compare-and-swap on the tail alone.
+// A call that finds its state already stored with a move count no 
+// higher than its own writes nothing to shared memory.
+//
+// A thread claims an empty slot by changing its tail from Empty to 
+// Busy, then stores _part0, then the real tail.  Other threads that
+// find a Busy tail wait for the real one. Keys, once stored, never
+// change.
+//
+// The table never grows.  If it gets so crowded that a call finds
+// neither its state nor an empty slot in MaxProbes tries, the call 
+// returns true.  That costs some duplicated work but never a solution.
+class LockFreeTable : public ClosedList
+{
+    static constexpr std::uint64_t Empty = 0;
+    static constexpr std::uint64_t Busy = ~std::uint64_t(0);
+    static constexpr unsigned MaxProbes = 256;
+    static constexpr unsigned MoveCountBits = 15;
+    struct Slot
+    {
+        std::atomic<std::uint64_t> _part0;
+        std::atomic<std::uint64_t> _tail;
+    };
+    static_assert(sizeof(Slot) == 16);
+    // Insertion counters, spread out to avoid contention
+    struct alignas(64) Counter
+    {
+        std::atomic<size_t> _count{0};
+    };
+    std::unique_ptr<Slot[]> _slots;
+    const size_t _mask;
+    std::array<Counter,64> _counters;
+public:
+    explicit LockFreeTable(size_t maxStates)
+        // Keep the load factor under 3/4.
+        : _mask(std::bit_ceil(std::max<size_t>(maxStates + maxStates/3, 1024)) - 1)
+    {
+        _slots = std::make_unique<Slot[]>(_mask+1);
+    }
+    bool IsShortPathToState(const GameState& state) noexcept override
+    {
+        const std::uint64_t part0 = state._part0;
+        const std::uint64_t part1 = state._part1;
+        const unsigned moveCount = state.MoveCount();
+        const std::uint64_t tail = part1 << MoveCountBits | moveCount;
+        // The key's 113 bits and move count leave room for Busy
+        // but not necessarily for Empty, which only a zero move 
+        // count can produce.
+        if (tail == Empty) return true;
+        const std::uint64_t hash = MixedHash(state);
+        size_t index = hash & _mask;
+        for (unsigned nProbes = 0; nProbes < MaxProbes; ++nProbes) {
+            Slot& slot = _slots[index];
+            std::uint64_t oldTail = slot._tail.load(std::memory_order_acquire);
+            if (oldTail == Empty) {
+                if (slot._tail.compare_exchange_strong(oldTail, Busy, 
+                        std::memory_order_acquire)) {
+                    slot._part0.store(part0, std::memory_order_relaxed);
+                    slot._tail.store(tail, std::memory_order_release);
+                    _counters[hash >> 58]._count.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                // Another thread claimed the slot first.  oldTail is now
+                // the value it stored.
+            }
+            while (oldTail == Busy) {
+                std::this_thread::yield();
+                oldTail = slot._tail.load(std::memory_order_acquire);
+            }
+            if (oldTail >> MoveCountBits == part1
+                    && slot._part0.load(std::memory_order_relaxed) == part0) {
+                // Found it.  Store the minimum of the two move counts.
+                while ((oldTail & 0x7fff) > moveCount) {
+                    if (slot._tail.compare_exchange_weak(oldTail, tail,
+                            std::memory_order_acq_rel, std::memory_order_acquire))
+                        return true;
+                }
+                return false;
+            }
+            index = (index + 1) & _mask;
+        }
+        return true;
+    }
+    size_t Size() const noexcept override
+    {
+        size_t result{0};
+        for (auto& counter: _counters)
+            result += counter._count.load(std::memory_order_relaxed);
+        return result;
+    }
+};
+
+// A closed list that keeps only its most recently added states in
+// main memory.  When that part grows past HotStates states, it is 
+// sorted and written to a temporary file as a run, and emptied. 
+//
+// For each run, main memory keeps a Bloom filter (about 10 bits per
+// state) and the first key in each page of PageSize states.  A call
+// for a state not found in main memory checks the runs from newest
+// to oldest, reading at most one page from each run whose Bloom 
+// filter admits the state.  A state found in a run is entered in
+// main memory only if the call has found a shorter path, so the
+// newest copy of any state holds its lowest move count.
+class SpillingSet : public ClosedList
+{
+    static constexpr size_t HotStates = 1U<<24;
+    static constexpr unsigned PageSize = 256;
+    static constexpr unsigned BloomBitsPerState = 10;
+    static constexpr unsigned BloomHashes = 7;
+    typedef phmap::parallel_flat_hash_set< 
+            GameState, 
+            Hasher,
+            phmap::priv::hash_default_eq<GameState>,
+            phmap::priv::Allocator<GameState >, 
+            8U,
+            std::mutex
+        > SetType;
+
+    struct Run
+    {
+        SpillFile _file;
+        size_t _size{0};
+        std::vector<GameState> _firstKeys;    // first key in each page
+        std::vector<std::uint64_t> _bloom;
+
+        bool MayContain(std::uint64_t hash) const noexcept
+        {
+            const std::uint64_t nBits = _bloom.size()*64;
+            const std::uint64_t h2 = (hash >> 32) | 1;
+            for (unsigned i = 0; i < BloomHashes; ++i) {
+                const std::uint64_t bit = (hash + i*h2) % nBits;
+                if (!(_bloom[bit/64] >> (bit%64) & 1)) return false;
+            }
+            return true;
+        }
+        void AddToBloom(std::uint64_t hash) noexcept
+        {
+            const std::uint64_t nBits = _bloom.size()*64;
+            const std::uint64_t h2 = (hash >> 32) | 1;
+            for (unsigned i = 0; i < BloomHashes; ++i) {
+                const std::uint64_t bit = (hash + i*h2) % nBits;
+                _bloom[bit/64] |= std::uint64_t(1) << (bit%64);
+            }
+        }
+    };
+    static bool KeyLess(const GameState& a, const GameState& b) noexcept
+    {
+        return a._part1 < b._part1 || (a._part1 == b._part1 && a._part0 < b._part0);
+    }
+
+    SetType _hot;
+    std::atomic<size_t> _hotInserts{0};
+    std::atomic<size_t> _coldSize{0};
+    std::vector<std::unique_ptr<Run>> _runs;
+    // Held shared by calls to IsShortPathToState(), exclusively by Spill()
+    std::shared_mutex _runsMutex;
+    std::atomic_flag _spilling = ATOMIC_FLAG_INIT;
+    std::atomic<bool> _spillOff{false};    // a run could not be written
+
+    // Returns the move count stored for state in run, or 0 if none.
+    static unsigned Find(Run& run, const GameState& state) noexcept
+    {
+        auto page = std::upper_bound(run._firstKeys.begin(), run._firstKeys.end(), 
+                        state, KeyLess) - run._firstKeys.begin() - 1;
+        if (page < 0) return 0;
+        const size_t first = size_t(page)*PageSize;
+        const size_t count = std::min<size_t>(PageSize, run._size - first);
+        std::array<GameState,PageSize> buffer;
+        // A page that cannot be read is treated as not holding the
+        // state.  That costs a repeated expansion, never a lost path.
+        if (!run._file.Read(first*sizeof(GameState), buffer.data(), count*sizeof(GameState)))
+            return 0;
+        auto found = std::lower_bound(buffer.begin(), buffer.begin()+count, state, KeyLess);
+        if (found != buffer.begin()+count && *found == state)
+            return found->MoveCount();
+        return 0;
+    }
+    // Move the contents of _hot to a new run.  If the run cannot be
+    // written, keep everything in memory from now on.
+    void Spill() noexcept
+    {
+        std::unique_lock<std::shared_mutex> lock(_runsMutex);
+        auto run = std::make_unique<Run>();
+        if (!run->_file.IsOpen()) {
+            _spillOff = true;
+            return;
+        }
+        std::vector<GameState> states;
+        states.reserve(_hot.size());
+        _hot.for_each([&](const GameState& state) {states.push_back(state);});
+        std::sort(states.begin(), states.end(), KeyLess);
+        run->_size = states.size();
+        std::uint64_t offset;
+        if (!run->_file.Append(states.data(), states.size()*sizeof(GameState), offset)) {
+            _spillOff = true;
+            return;
+        }
+        run->_bloom.resize(std::max<size_t>(1, states.size()*BloomBitsPerState/64));
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (i % PageSize == 0) run->_firstKeys.push_back(states[i]);
+            run->AddToBloom(MixedHash(states[i]));
+        }
+        _coldSize += states.size();
+        _runs.push_back(std::move(run));
+        _hot.clear();
+        _hotInserts = 0;
+    }
+public:
+    explicit SpillingSet(size_t minCapacity)
+    {
+        _hot.reserve(std::min(minCapacity, HotStates));
+    }
+    bool IsShortPathToState(const GameState& state) noexcept override
+    {
+        bool result;
+        {
+            std::shared_lock<std::shared_mutex> lock(_runsMutex);
+            const unsigned moveCount = state.MoveCount();
+            bool valueChanged{false};
+            const bool found = _hot.modify_if(state,
+                [&](GameState& oldState) {
+                    if (moveCount < oldState.MoveCount()) {
+                        oldState.SetMoveCount(moveCount);
+                        valueChanged = true;
+                    }
+                });
+            if (found) return valueChanged;
+            // Not in main memory.  Look in the runs.
+            const std::uint64_t hash = MixedHash(state);
+            unsigned oldCount{0};
+            for (auto run = _runs.rbegin(); !oldCount && run != _runs.rend(); ++run) {
+                if ((*run)->MayContain(hash))
+                    oldCount = Find(**run, state);
+            }
+            result = oldCount == 0 || moveCount < oldCount;
+            if (result) {
+                // Another thread may have entered this state since we looked.
+                _hot.lazy_emplace_l(state,
+                    [&](GameState& oldState) {
+                        if (moveCount < oldState.MoveCount())
+                            oldState.SetMoveCount(moveCount);
+                        else 
+                            result = false;
+                    },
+                    [&](const SetType::constructor& ctor) {ctor(state);}
+                );
+                if (result) ++_hotInserts;
+            }
+        }
+        if (_hotInserts > HotStates && !_spillOff && !_spilling.test_and_set()) {
+            if (_hotInserts > HotStates) Spill();
+            _spilling.clear();
+        }
+        return result;
+    }
+    size_t Size() const noexcept override
+    {
+        return _hot.size() + _coldSize;
+    }
+};
+
+// An exact closed list that forgets states reached by far fewer moves
+// than the longest path seen so far.  In best-first order, leaves with
+// very different move counts are open at once, so some forgotten
+// states may still be in the fringe or near it.  Forgetting a state
+// never loses a path, so solutions found are still shortest: a 
+// regenerated state is stored again and costs an extra expansion.
+// But cycles through forgotten states go undetected, so a search
+// with no solution may go on until KSolveAStar() cuts off sequences 
+// for length and reports GaveUp.  The solution path is recovered
+// from the move tree, so nothing else needs the interior.
+class FrontierSet : public PhmapClosedList<GameState,Hasher,8U,std::mutex>
 {
-    const GameState newState{game,moveCount};
-    bool valueChanged{false};
-    bool isNewKey = _states.lazy_emplace_l(
-        newState,						// (key, value)
-        [&](auto& oldState) {	// run behind lock when key found
-            if (moveCount < oldState._moveCount) {
-                oldState._moveCount = moveCount;
-                valueChanged = true;
+    using Base = PhmapClosedList<GameState,Hasher,8U,std::mutex>;
+    // States with move counts this far below the longest are forgotten.
+    static constexpr unsigned Window = 32;
+    std::atomic<unsigned> _nextSweep{Window};
+    std::atomic_flag _sweeping = ATOMIC_FLAG_INIT;
+
+    // Remove states with move counts below floor.  Each submap is 
+    // locked only while it is swept.
+    void Sweep(unsigned floor) noexcept
+    {
+        for (size_t i = 0; i < _states.subcnt(); ++i) {
+            _states.with_submap_m(i, [floor](auto& submap) {
+                phmap::priv::erase_if(submap, 
+                    [floor](const GameState& s) {return s.MoveCount() < floor;});
+            });
+        }
+    }
+public:
+    using Base::Base;
+    bool IsShortPathToState(const GameState& state) noexcept override
+    {
+        const bool result = Base::IsShortPathToState(state);
+        const unsigned moveCount = state.MoveCount();
+        if (moveCount >= _nextSweep.load(std::memory_order_relaxed) 
+                && !_sweeping.test_and_set()) {
+            if (moveCount >= _nextSweep) {
+                Sweep(moveCount - Window);
+                _nextSweep = moveCount + Window/4;
             }
-        },
-        [&](const MapType::constructor& ctor) { // ... if key not found
-            ctor(newState);
+            _sweeping.clear();
         }
-    );
-    return isNewKey | valueChanged;
+        return result;
+    }
+};
+
+// Return a phmap closed list with about 16 submaps per thread
+template <class MutexT>
+std::unique_ptr<ClosedList> MakeTunedClosedList(unsigned threads, size_t minCapacity)
+{
+    const unsigned logSubmaps = std::bit_width(std::max(threads,1U)-1) + 4;
+    if (logSubmaps <= 4)
+        return std::make_unique<PhmapClosedList<GameState,Hasher,4U,MutexT>>(minCapacity);
+    else if (logSubmaps <= 6)
+        return std::make_unique<PhmapClosedList<GameState,Hasher,6U,MutexT>>(minCapacity);
+    else if (logSubmaps <= 8)
+        return std::make_unique<PhmapClosedList<GameState,Hasher,8U,MutexT>>(minCapacity);
+    else
+        return std::make_unique<PhmapClosedList<GameState,Hasher,10U,MutexT>>(minCapacity);
+}
+}   // namespace
+
+std::unique_ptr<ClosedList> MakeClosedList(ClosedListKind kind, 
+                                           unsigned threads, 
+                                           size_t minCapacity,
+                                           size_t maxStates)
+{
+    switch (kind) {
+        case LossyClosedList:
+            return std::make_unique<PhmapClosedList<StateFingerprint,FingerprintHasher,8U,std::mutex>>(minCapacity);
+        case SpinLockClosedList:
+            return std::make_unique<PhmapClosedList<GameState,Hasher,8U,SpinLock>>(minCapacity);
+        case SharedMutexClosedList:
+            return std::make_unique<PhmapClosedList<GameState,Hasher,8U,std::shared_mutex>>(minCapacity);
+        case TunedClosedList:
+            return MakeTunedClosedList<std::mutex>(threads, minCapacity);
+        case ShardedStdClosedList:
+            return std::make_unique<ShardedStdSet>(minCapacity);
+        case ExternalClosedList:
+            return std::make_unique<SpillingSet>(minCapacity);
+        case LockFreeClosedList:
+            return std::make_unique<LockFreeTable>(std::max(minCapacity,maxStates));
+        case FrontierClosedList:
+            return std::make_unique<FrontierSet>(minCapacity);
+        case ExactClosedList:
+        default:
+            return std::make_unique<PhmapClosedList<GameState,Hasher,8U,std::mutex>>(minCapacity);
+    }
+}
+
+GameStateMemory::GameStateMemory(ClosedListKind kind, 
+                                 unsigned threads, 
+                                 size_t maxStates) noexcept
+    : _kind(kind)
+    , _states(MakeClosedList(kind, threads, MinCapacity, maxStates))
+{
 }
-}   // namespace KSolveNames
\ No newline at end of file
+}   // namespace KSolveNames
@@ -5,10 +5,16 @@
 // length of the shortest path to each state encountered so far.
 //
 // Instances are thread-safe.
+//
+// The storage itself is one of several interchangeable ClosedList
+// implementations, chosen at run time by a ClosedListKind.
+
+#ifndef GAMESTATEMEMORY_HPP
+#define GAMESTATEMEMORY_HPP
 
 #include "Game.hpp"                     // for Game
-#include "parallel_hashmap/phmap.h"     // for parallel_flat_hash_set
-#include <mutex>
+#include "SolverOptions.hpp"            // for ClosedListKind
+#include <memory>                       // for std::unique_ptr
 namespace KSolveNames {
 // A compact representation of the current game state.
 //
@@ -31,55 +37,155 @@ namespace KSolveNames {
 // it is implemented as a hash set so the value can be packed in
 // with the key.  The hash and compare functions operate only on
 // the key.
+//
+// The key is 113 bits long.  Each tableau pile is given a code
+// below 2^15 (see TableauCode() in GameStateMemory.cpp).  The sorted
+// list of seven such codes is replaced by its rank among all
+// such sorted lists, which takes 93 bits.  The stock pile size and
+// the foundation pile sizes take 20 more. That leaves 15 bits for
+// the move count, which is plenty, since the fringe cannot hold
+// sequences more than a few hundred moves long.
 struct GameState {
     using PartType = std::uint64_t;
     PartType _part0;            // key[0]
-    PartType _part1;            // key[1]
-    PartType _part2:48;         // key[2]
-    PartType _moveCount:16;     // value
+    PartType _part1:49;         // key[1]
+    PartType _moveCount:15;     // value
     GameState(const Game& game, unsigned moveCount) noexcept;
+    // An all-zero key (which no real game state produces) with 
+    // the highest possible move count
+    GameState() noexcept
+        : _part0(0)
+        , _part1(0)
+        , _moveCount(0x7fff)
+        {}
+    unsigned MoveCount() const noexcept {return _moveCount;}
+    void SetMoveCount(unsigned moveCount) noexcept {_moveCount = moveCount;}
     bool operator==(const GameState& other) const noexcept
     {
         return _part0 == other._part0
-            && _part1 == other._part1
-            && _part2 == other._part2;
+            && _part1 == other._part1;
     }
 };
-static_assert(sizeof(GameState) == 24);
+static_assert(sizeof(GameState) == 16);
 struct Hasher
 {
     size_t operator() (const GameState & gs) const noexcept
     {
         return 	  gs._part0
                 ^ gs._part1
-                ^ gs._part2
                 ;
     }
 };
 
+// A lossy stand-in for a GameState.  The high 49 bits are a 
+// fingerprint (a hash) of the key of a GameState.  The low
+// 15 bits are the move count.
+struct StateFingerprint {
+    std::uint64_t _value;
+    StateFingerprint(const GameState& state) noexcept;
+    unsigned MoveCount() const noexcept {return _value & 0x7fff;}
+    void SetMoveCount(unsigned moveCount) noexcept
+    {
+        _value = (_value & ~std::uint64_t(0x7fff)) | moveCount;
+    }
+    bool operator==(const StateFingerprint& other) const noexcept
+    {
+        return (_value ^ other._value) >> 15 == 0;
+    }
+};
+static_assert(sizeof(StateFingerprint) == 8);
+struct FingerprintHasher
+{
+    size_t operator() (const StateFingerprint & fp) const noexcept
+    {
+        return fp._value >> 15;
+    }
+};
+
+// The interface shared by all closed list implementations.
+class ClosedList
+{
+public:
+    virtual ~ClosedList() = default;
+    // Returns true if no state with the same key as the argument has 
+    // been presented before or the argument's move count is lower than 
+    // that associated with previous calls with equal keys.
+    virtual bool IsShortPathToState(const GameState& state) noexcept = 0;
+    // Returns the number of states stored.
+    virtual size_t Size() const noexcept = 0;
+};
+
+// Returns a new ClosedList of the given kind suited to the given
+// number of threads.  Initial capacity will be at least minCapacity.
+// Kinds that cannot grow are sized to hold maxStates states.
+std::unique_ptr<ClosedList> MakeClosedList(ClosedListKind kind, 
+                                           unsigned threads,
+                                           size_t minCapacity,
+                                           size_t maxStates);
+
 class GameStateMemory
 {
 private:
-    typedef phmap::parallel_flat_hash_set< 
-            GameState, 								// key type
-            Hasher,									// hash function
-            phmap::priv::hash_default_eq<GameState>,// == function
-            phmap::priv::Allocator<GameState >, 
-            8U, 									// log2(number of submaps)
-            std::mutex								// mutex type
-        > MapType;
-    MapType _states;
+    const ClosedListKind _kind;
+    std::unique_ptr<ClosedList> _states;
 
     // Starting minimum capacity for hash map
-    const unsigned MinCapacity = 4096*1024;
+    static constexpr unsigned MinCapacity = 4096*1024;
 
 public:
-    GameStateMemory() noexcept;
+    explicit GameStateMemory(ClosedListKind kind = ExactClosedList,
+                             unsigned threads = 0,
+                             size_t maxStates = 0) noexcept;
     // Returns true if no equal Game argument has been presented before
     // to this object or the moveCount argument is lower than that
     // associated with previous calls with equal states.
-    bool IsShortPathToState(const Game& game, unsigned moveCount) noexcept;
+    //
+    // If this is lossy (see IsLossy()), it may rarely return false 
+    // when it should return true. 
+    bool IsShortPathToState(const Game& game, unsigned moveCount) noexcept
+    {
+        return _states->IsShortPathToState(GameState{game,moveCount});
+    }
+    bool IsShortPathToState(const GameState& state) noexcept
+    {
+        return _states->IsShortPathToState(state);
+    }
     // Returns the number of states stored.  
-    size_t Size()  noexcept {return _states.size();}
+    size_t Size()  noexcept {return _states->Size();}
+    // Returns true if IsShortPathToState() can return false negatives
+    bool IsLossy() const noexcept {return _kind == LossyClosedList;}
 };
-}   // namespace KSolveNames
\ No newline at end of file
+
+// A small direct-mapped cache of recently seen {GameState, move count}
+// pairs meant to stand in front of a GameStateMemory shared among 
+// threads.  Each thread should have its own.
+//
+// Move counts in the shared GameStateMemory never increase, so
+// the move count cached for a state is never less than the one
+// stored for it there, even after another thread has found a 
+// shorter path.  A path no shorter than the cached move count 
+// can therefore be rejected without consulting the shared memory.
+class RecentStateCache
+{
+    static constexpr unsigned LogSize = 14;
+    std::vector<GameState> _states;
+public:
+    RecentStateCache()
+        : _states(1U<<LogSize)
+        {}
+    // Returns what shared.IsShortPathToState(state) would.
+    bool IsShortPathToState(const GameState& state, GameStateMemory& shared) noexcept
+    {
+        const size_t hash = Hasher()(state) * 0x9e3779b97f4a7c15ULL;
+        GameState& cached = _states[hash >> (64 - LogSize)];
+        if (cached == state && cached.MoveCount() <= state.MoveCount())
+            return false;
+        // Whatever the answer, the shared memory now holds a move count 
+        // for this state no greater than state's.
+        cached = state;
+        return shared.IsShortPathToState(state);
+    }
+};
+}   // namespace KSolveNames
+
+#endif      // GAMESTATEMEMORY_HPP
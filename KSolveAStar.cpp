@@ -1,6 +1,10 @@
 #include "KSolveAStar.hpp"
+#include "CandidateSolution.hpp"
+#include "KSolveGreedy.hpp"
+#include "EndgameTable.hpp"
 #include "GameStateMemory.hpp"
 #include "MoveStorage.hpp"
+#include <atomic>
 #include <thread>
 
 namespace KSolveNames {
@@ -13,34 +17,6 @@ unsigned DefaultThreads() noexcept
     return std::thread::hardware_concurrency();
 }
 
-class CandidateSolution
-{
-private:
-    Moves _sol;
-    unsigned _count {-1U};
-    Mutex _mutex;
-public:
-    const Moves & GetMoves() const noexcept
-    {
-        return _sol;
-    }
-    unsigned MoveCount() const noexcept{
-        return _count;
-    }
-    template <class Container>
-    void ReplaceIfShorter(const Container& source, unsigned count) noexcept
-    {
-        if (_sol.empty() || count < _count){
-            Guard nikita(_mutex);
-            if (_sol.empty() || count < _count){
-                _sol.assign(source.begin(), source.end());
-                _count = count;
-            }
-        }
-    }
-    bool IsEmpty() const noexcept {return _sol.empty();}
-};
-
 // Counts the number of times a card is higher in the stack
 // than a lower card of the same suit.  Remember that the 
 // stack tops are at the back.
@@ -60,6 +36,51 @@ unsigned MisorderCount(Iter begin, Iter end) noexcept
     return result;
 }
 
+// Return a lower bound on the moves beyond one per card needed to
+// clear the waste pile.  A waste card above a lower card of its own
+// suit (a misordered card) cannot go straight to the foundation.
+// Before that lower card can leave, either the misordered card makes
+// an extra move to the tableau, or the waste is recycled with it.
+// Recycling keeps the order of the talon, as TalonSim shows, so the
+// card comes back misordered, and getting it back takes at least
+// ceil(p/draw) draws, where p is its height in the waste.  Those draws
+// are not counted by the stock term until the recycle.
+//
+// So if the misordered cards are at heights p[0] < p[1] < ... , the
+// bound is the least, over the number j of them that make extra moves
+// from the top down, of j + ceil(p[M-1-j]/draw), or M if every one
+// of the M does.  Drawing never lowers this bound, playing a card that
+// is not misordered leaves it alone, and playing a misordered card
+// lowers it by at most one.  A recycle can lower it by no more than
+// it raises the stock term.  For draw setting 1, this is MisorderCount()
+// of the waste.
+//
+// Draw is the draw setting, or 0 to use game.DrawSetting().
+template <unsigned Draw>
+static unsigned WasteMisorderMoves(const Game& game) noexcept
+{
+    const unsigned draw = Draw ? Draw : game.DrawSetting();
+    const bool canRecycle = game.RecycleCount() < game.RecycleLimit();
+    unsigned minRanks[SuitsPerDeck] {14,14,14,14};
+    static_vector<unsigned char,24> heights;
+    const auto& waste = game.WastePile();
+    for (unsigned i = 0; i < waste.size(); ++i) {
+        const auto rank = waste[i].Rank();
+        const auto suit = waste[i].Suit();
+        if (rank < minRanks[suit])
+            minRanks[suit] = rank;
+        else
+            heights.push_back(i+1);
+    }
+    const unsigned nMisordered = heights.size();
+    unsigned result = nMisordered;
+    if (draw > 1 && canRecycle) {
+        for (unsigned i = 0; i < nMisordered; ++i)
+            result = std::min(result, nMisordered-1-i + QuotientRoundedUp(heights[i],draw));
+    }
+    return result;
+}
+
 // Return a lower bound on the number of moves required to complete
 // this game.  This function must return a result that does not 
 // decrease by more than one after any single move.  The sum of 
@@ -74,18 +95,19 @@ unsigned MisorderCount(Iter begin, Iter end) noexcept
 //		or monotone, if its estimate is always less than or equal 
 //		to the estimated distance from any neighbouring vertex to 
 //		the goal, plus the cost of reaching that neighbour.
+//
+// Draw is the draw setting, or 0 to use game.DrawSetting().  Worker()
+// calls the instance for its game's draw setting, so the common
+// settings divide by constants.
+template <unsigned Draw>
 unsigned MinimumMovesLeft(const Game& game) noexcept
 {
-    const unsigned draw = game.DrawSetting();
+    const unsigned draw = Draw ? Draw : game.DrawSetting();
     const unsigned talonCount = 
         game.WastePile().size() + game.StockPile().size();
 
-    unsigned result = talonCount + QuotientRoundedUp(game.StockPile().size(),draw);
-
-    if (draw == 1) {
-        // This can fail the consistency test for draw setting > 1.
-        result += MisorderCount(game.WastePile().begin(), game.WastePile().end());
-    }
+    unsigned result = talonCount + QuotientRoundedUp(game.StockPile().size(),draw)
+        + WasteMisorderMoves<Draw>(game);
 
     for (const auto & tPile: game.Tableau()) {
         if (tPile.size()) {
@@ -97,6 +119,57 @@ unsigned MinimumMovesLeft(const Game& game) noexcept
     return result;
 }
 
+unsigned MinimumMovesLeft(const Game& game) noexcept
+{
+    switch (game.DrawSetting()) {
+    case 1:  return MinimumMovesLeft<1>(game);
+    case 3:  return MinimumMovesLeft<3>(game);
+    default: return MinimumMovesLeft<0>(game);
+    }
+}
+
+// Return true if some card in the tableau can never move.  A card
+// other than a king can leave its pile only for the foundation or
+// for a card of the next higher rank and the other color.  If a
+// lower card of its own suit and both of those cards lie beneath it
+// in the same pile, none of them can be reached until it leaves, so
+// it never can, and the game cannot be won.  Cheap enough to call on
+// every deal.
+//
+// Only face-down cards and the lowest face-up card of each pile are
+// tested.  The cards beneath those are all face down, so none of them
+// can move first.  A face-up card higher in a pile can leave as part
+// of a run whose base is lower down, which takes it off the cards it
+// needs.
+bool IsDeadlocked(const Game& game) noexcept
+{
+    for (const auto & tPile: game.Tableau()) {
+        std::uint64_t beneath = 0;      // bit v set for each card beneath
+        const unsigned nTested = tPile.size() - tPile.UpCount() + 1;
+        for (const Card card: tPile | views::take(nTested)) {
+            const unsigned rank = card.Rank();
+            if (rank != Card::King) {
+                const unsigned suit = card.Suit();
+                const std::uint64_t lower = 
+                    ((std::uint64_t(1) << rank) - 1) << suit*CardsPerSuit;
+                // The suits of the other color have the other low bit.
+                const unsigned other = (suit & 1) ^ 1;
+                const std::uint64_t parents = 
+                      std::uint64_t(1) << (other*CardsPerSuit + rank + 1)
+                    | std::uint64_t(1) << ((other+2)*CardsPerSuit + rank + 1);
+                if ((beneath & lower) && (beneath & parents) == parents) 
+                    return true;
+            }
+            beneath |= std::uint64_t(1) << card.Value();
+        }
+    }
+    return false;
+}
+
+// The longest move sequence expanded.  MoveStorage holds 500 moves
+// in a sequence, which leaves room for a stem.
+static constexpr unsigned MaxPathLength = 400;
+
 struct WorkerState {
 public:
     Game _game;
@@ -112,22 +185,64 @@ public:
     // its move count here.  If not, we forget the current node - we already have a
     // way to get to the same state that is at least as short.
     GameStateMemory& _closedList;
+    // _recentStates remembers some of the states this thread has 
+    // recently offered to _closedList, so it need not offer them again.
+    RecentStateCache _recentStates;
     CandidateSolution & _minSolution;
+    // Total number of leaves expanded by all threads
+    std::atomic<size_t>& _expansionCount;
+    // Set when another search engine has proven its goal
+    const std::atomic<bool>& _stop;
+    // Stop when the solution is no more than this factor times
+    // the minimum moves of any leaf in the fringe.
+    double _focalFactor;
+    // The lowest minimum move count in the fringe seen by any thread
+    // as it stopped.  No solution can be shorter.
+    std::atomic<unsigned>& _lowerBound;
+    // The lowest minimum move count of any sequence cut off because
+    // it was longer than MaxPathLength.  No solution through them
+    // can be shorter.
+    std::atomic<unsigned>& _cutBound;
+    // Use partial expansion (see Worker())
+    bool _partialExpansion;
+    // Exact numbers of moves left near the end of the game, if any
+    EndgameTable* _endgame;
 
     explicit WorkerState(  Game & gm, 
             CandidateSolution& solution,
             SharedMoveStorage& sharedMoveStorage,
-            GameStateMemory& closed)
+            GameStateMemory& closed,
+            std::atomic<size_t>& expansionCount,
+            const std::atomic<bool>& stop,
+            double focalFactor,
+            std::atomic<unsigned>& lowerBound,
+            std::atomic<unsigned>& cutBound,
+            bool partialExpansion,
+            EndgameTable* endgame)
         : _game(gm)
         , _moveStorage(sharedMoveStorage)
         , _closedList(closed)
         , _minSolution(solution)
+        , _expansionCount(expansionCount)
+        , _stop(stop)
+        , _focalFactor(focalFactor)
+        , _lowerBound(lowerBound)
+        , _cutBound(cutBound)
+        , _partialExpansion(partialExpansion)
+        , _endgame(endgame)
         {}
     explicit WorkerState(const WorkerState& orig)
         : _game(orig._game)
         , _moveStorage(orig._moveStorage.Shared())
         , _closedList(orig._closedList)
         , _minSolution(orig._minSolution)
+        , _expansionCount(orig._expansionCount)
+        , _stop(orig._stop)
+        , _focalFactor(orig._focalFactor)
+        , _lowerBound(orig._lowerBound)
+        , _cutBound(orig._cutBound)
+        , _partialExpansion(orig._partialExpansion)
+        , _endgame(orig._endgame)
         {}
             
     QMoves MakeAutoMoves() noexcept;
@@ -152,6 +267,8 @@ QMoves WorkerState::MakeAutoMoves() noexcept
 /*************************************************************************/
 /*************************** Main Loop ***********************************/
 /*************************************************************************/
+// Draw is the draw setting of the game, or 0 for any draw setting.
+template <unsigned Draw>
 static void Worker(
         WorkerState* pMasterState) noexcept
 {
@@ -163,10 +280,14 @@ static void Worker(
     CandidateSolution&  minSolution {state._minSolution};
     GameStateMemory&    closedList{state._closedList};
 
-    unsigned minMoves0;
+    unsigned minMoves0 = -1U;
+    size_t expansionCount = 0;
     while ( !moveStorage.Shared().OverLimit()
-            && (minMoves0 = moveStorage.PopNextMoveSequence())    // <- side effect
-            && minMoves0 < minSolution.MoveCount()) { 
+            && !state._stop
+            && (minMoves0 = moveStorage.PopNextMoveSequence(
+                    minSolution.MoveCount()))                       // <- side effect
+            && moveStorage.FringeMinMoves()*state._focalFactor < minSolution.MoveCount()) { 
+        ++expansionCount;
 
         // Restore game to the state it had when this move
         // sequence was enqueued.
@@ -174,6 +295,15 @@ static void Worker(
         moveStorage.LoadMoveSequence();
         moveStorage.MakeSequenceMoves(game);
 
+        // Only cycles a closed list failed to detect (as FrontierClosedList
+        // can) make sequences this long.  Cut them off.
+        if (moveStorage.MoveSequence().size() > MaxPathLength) {
+            unsigned prior = state._cutBound;
+            while (minMoves0 < prior 
+                && !state._cutBound.compare_exchange_weak(prior, minMoves0)) {}
+            continue;
+        }
+
         // Make all the no-choice (stem) moves.  Returns the first choice of moves
         // (the branches from next branching node) or an empty set.
         QMoves availableMoves = state.MakeAutoMoves();
@@ -181,14 +311,74 @@ static void Worker(
         const unsigned movesMadeCount = 
             moveStorage.MoveSequence().MoveCount();
 
-        if (availableMoves.empty()) {
+        // If every card left can go straight to the foundation, or if
+        // few enough cards are left for the endgame table, the shortest
+        // finish from here can be found without expanding this node.
+        Moves finish;
+        EndgameOutcome endgame = EndgameUnknown;
+        if (availableMoves.size()) {
+            if (game.IsTrivialFinish()) {
+                finish = game.TrivialFinish();
+                endgame = EndgameWin;
+            } else if (state._endgame) {
+                endgame = state._endgame->Finish(game, finish);
+            }
+        }
+
+        if (endgame == EndgameWin) {
+            Moves solution(moveStorage.MoveSequence().begin(),
+                           moveStorage.MoveSequence().end());
+            solution.insert(solution.end(), finish.begin(), finish.end());
+            if (minSolution.ReplaceIfShorter(
+                    solution, movesMadeCount + MoveCount(finish)))
+                moveStorage.Shared().DropFringeAtOrAbove(minSolution.MoveCount());
+        } else if (endgame == EndgameLoss) {
+            // The game cannot be won from here.
+        } else if (availableMoves.empty()) {
             // This could be a dead end or a win.
             if (game.GameOver()) {
-                // We have a win.  See if it is a new champion
-                minSolution.ReplaceIfShorter(
-                    moveStorage.MoveSequence(), movesMadeCount);
+                // We have a win.  See if it is a new champion.
+                // If so, no leaf in the fringe that cannot lead to a 
+                // shorter solution will ever be needed.
+                if (minSolution.ReplaceIfShorter(
+                        moveStorage.MoveSequence(), movesMadeCount))
+                    moveStorage.Shared().DropFringeAtOrAbove(minSolution.MoveCount());
+            }
+        } else if (state._partialExpansion) {
+            // Partial expansion.  Save only the children whose minimum
+            // move counts equal the parent's (as stored in the fringe).
+            // Children with lower ones were saved when the parent was 
+            // expanded before.  If there are children with higher
+            // ones, put the parent back in the fringe with the lowest 
+            // of those, to be expanded again when that comes up.
+            unsigned nextMinMoves = -1U;
+            for (auto mv: availableMoves){
+                game.MakeMove(mv);
+                const unsigned made = movesMadeCount + mv.NMoves();
+                const unsigned minRemaining = MinimumMovesLeft<Draw>(game);
+                const unsigned minMoves = made + minRemaining;
+                if (minMoves >= minSolution.MoveCount()) {
+                    // no improvement possible
+                } else if (minMoves > minMoves0) {
+                    nextMinMoves = std::min(nextMinMoves, minMoves);
+                } else if (minMoves == minMoves0 
+                        && state._recentStates.IsShortPathToState(
+                            GameState{game, made}, closedList)) { // <- side effect
+                    moveStorage.PushBranch(mv,minMoves,minRemaining);
+                }
+                game.UnMakeMove(mv);
             }
+            if (nextMinMoves != -1U) 
+                moveStorage.PushBranch(MoveSpec(), nextMinMoves, 
+                                       nextMinMoves - movesMadeCount);
+            moveStorage.ShareMoves(minSolution.MoveCount());
         } else {
+#ifndef NDEBUG
+            // The parent's own estimate, for the consistency assert below.
+            // The endgame table may have raised minMoves0 above it.
+            const unsigned parentMinMoves = state._endgame
+                ? movesMadeCount + MinimumMovesLeft<Draw>(game) : minMoves0;
+#endif
             // Save the result of each of the possible next moves.
             for (auto mv: availableMoves){
                 game.MakeMove(mv);
@@ -204,28 +394,46 @@ static void Worker(
                 // MinimumMovesLeft().
                 unsigned minRemaining = -1U;
                 bool pass = true;
-                if (!minSolution.IsEmpty()) { 
-                    minRemaining = MinimumMovesLeft(game); // expensive
-                    pass = (made + minRemaining) < minSolution.MoveCount();
+                const unsigned bound = minSolution.MoveCount();
+                if (bound != -1U) { 
+                    minRemaining = MinimumMovesLeft<Draw>(game); // expensive
+                    pass = (made + minRemaining) < bound;
                 }
-                if (pass && closedList.IsShortPathToState(game, made)) { // <- side effect
-                    if (minRemaining == -1U) minRemaining = MinimumMovesLeft(game);
-                    const unsigned minMoves = made + minRemaining;
+                if (pass && state._recentStates.IsShortPathToState(
+                        GameState{game, made}, closedList)) { // <- side effect
+                    if (minRemaining == -1U) minRemaining = MinimumMovesLeft<Draw>(game);
                     // The following assert tests the consistency (monotonicity)
                     // of MinimumMovesLeft(), our heuristic.  
                     // Never remove it.
-                    assert(minMoves0 <= minMoves);
-                    moveStorage.PushBranch(mv,minMoves);
+                    assert(parentMinMoves <= made + minRemaining);
+                    // The endgame table may know exactly how many are left.
+                    // That makes the estimate inconsistent, so never let a
+                    // child's count fall below its parent's (pathmax).
+                    const unsigned known = 
+                        state._endgame ? state._endgame->Probe(game) : 0;
+                    if (known != EndgameTable::Unwinnable) {
+                        minRemaining = std::max(minRemaining, known);
+                        if (made + minRemaining < minMoves0)
+                            minRemaining = minMoves0 - made;
+                        moveStorage.PushBranch(mv,made+minRemaining,minRemaining);
+                    }
                 }
                 game.UnMakeMove(mv);
             }
             // Share the moves made here
-            moveStorage.ShareMoves();
+            moveStorage.ShareMoves(minSolution.MoveCount());
         }
     } 
+    state._expansionCount += expansionCount;
+    // If the fringe ran dry, every solution shorter than the
+    // best one found has been ruled out.
+    const unsigned lowerBound = minMoves0 ? moveStorage.FringeMinMoves() : -1U;
+    unsigned prior = state._lowerBound;
+    while (lowerBound < prior && !state._lowerBound.compare_exchange_weak(prior, lowerBound)) {}
     return;
 }
 
+template <unsigned Draw>
 static void RunWorkers(unsigned nThreads, WorkerState & state) noexcept
 {
     if (nThreads == 0)
@@ -235,13 +443,13 @@ static void RunWorkers(unsigned nThreads, WorkerState & state) noexcept
     std::vector<std::thread> threads;
     threads.reserve(nThreads-1);
     for (unsigned t = 0; t < nThreads-1; ++t) {
-        threads.emplace_back(&Worker, &state);
+        threads.emplace_back(&Worker<Draw>, &state);
         if (t == 0)     // MoveStorage must start single-threaded.
             std::this_thread::sleep_for(std::chrono::milliseconds(3));
     }
 
     // Run one more worker in this (main) thread
-    Worker(&state);
+    Worker<Draw>(&state);
 
     for (auto& thread: threads) 
         thread.join();
@@ -252,38 +460,107 @@ static void RunWorkers(unsigned nThreads, WorkerState & state) noexcept
 /*************************************************************************/
 KSolveAStarResult KSolveAStar(
         Game& game,
-        unsigned moveTreeLimit,
-        unsigned nThreads) noexcept
+        size_t moveTreeLimit,
+        unsigned nThreads,
+        ClosedListKind closedList,
+        TieBreak tieBreak,
+        bool portfolio,
+        double focalFactor,
+        bool partialExpansion,
+        EndgameTable* endgame,
+        unsigned greedyBudget) noexcept
 {
+    // Partial expansion cannot be combined with focal search.
+    if (partialExpansion && focalFactor > 1.0)
+        return KSolveAStarResult(InvalidOptions, Moves(), 0, 0, 0, 0, 0);
+    // The search starts from the deal, whatever moves game has made.
+    Game dealt(game);
+    dealt.Deal();
+    if (IsDeadlocked(dealt))
+        return KSolveAStarResult(Impossible, Moves(), 0, 0, 0, 0, -1U);
+    if (nThreads == 0)
+        nThreads = DefaultThreads();
     SharedMoveStorage sharedMoveStorage;
-    GameStateMemory closed;
+    // Closed lists that cannot grow are sized on the assumption that 
+    // searches store at most about four states per move tree node.
+    GameStateMemory closed(closedList, nThreads, 4*moveTreeLimit);
     CandidateSolution solution;
-    WorkerState state(game,solution,sharedMoveStorage,closed);
+    std::atomic<size_t> expansionCount{0};
+    std::atomic<bool> stop{false};
+    std::atomic<unsigned> lowerBound{-1U};
+    std::atomic<unsigned> cutBound{-1U};
+    WorkerState state(game,solution,sharedMoveStorage,closed,
+                      expansionCount,stop,focalFactor,lowerBound,
+                      cutBound,partialExpansion,endgame);
 
     const unsigned startMoves = MinimumMovesLeft(state._game);
 
+    // Start with a solution, however long, so that the search can
+    // prune from its first expansion.
+    const Moves seed = greedyBudget ? KSolveGreedy(game, greedyBudget) : Moves();
+    if (seed.size())
+        solution.ReplaceIfShorter(seed, MoveCount(seed));
+
     // Prime the pump
-    state._moveStorage.Shared().Start(moveTreeLimit,startMoves);
+    state._moveStorage.Shared().Start(moveTreeLimit,startMoves,tieBreak,focalFactor);
+    if (closedList == ExternalClosedList)
+        sharedMoveStorage.EnableFringeSpill();
     
-    RunWorkers(nThreads, state);
+    // In portfolio mode, a depth-first search shares the solution
+    // with the A* search.  It keeps its own closed list, since its
+    // paths to states are often not the shortest.  Whichever search 
+    // finishes first stops the other.
+    std::thread dfsThread;
+    bool dfsComplete = false;
+    if (portfolio && nThreads > 1) {
+        nThreads -= 1;
+        dfsThread = std::thread([&] {
+            dfsComplete = KSolveGreedy(game, solution, stop, -1, moveTreeLimit);
+            if (dfsComplete) stop = true;
+        });
+    }
+
+    // Choose the workers for the draw setting once, here.
+    switch (game.DrawSetting()) {
+    case 1:  RunWorkers<1>(nThreads, state); break;
+    case 3:  RunWorkers<3>(nThreads, state); break;
+    default: RunWorkers<0>(nThreads, state); break;
+    }
+    stop = true;
+    if (dfsThread.joinable())
+        dfsThread.join();
     
+    // A lossy closed list may have cut off the only paths to
+    // a shorter solution or to any solution.  If the depth-first
+    // search finished, it stopped the A* search early, but its own
+    // finish proves the result.
+    const bool complete = dfsComplete 
+        || (!sharedMoveStorage.OverLimit() && !closed.IsLossy());
+    // In focal search, a complete search proves only that no solution
+    // is shorter than the lower bound.
+    // Sequences cut off for length may hide longer solutions.
+    unsigned proven = std::min(lowerBound.load(), cutBound.load());
+    if (closed.IsLossy()) proven = 0;
+    if (dfsComplete) proven = -1U;
+    proven = std::min(proven, solution.MoveCount());
     KSolveAStarCode outcome;
     if (solution.GetMoves().size()) { 
-        outcome = sharedMoveStorage.OverLimit()
-                ? Solved
-                : SolvedMinimal;
+        outcome = (complete && proven == solution.MoveCount())
+                ? SolvedMinimal
+                : Solved;
     } else {
-        outcome = sharedMoveStorage.OverLimit()
-                ? GaveUp
-                : Impossible;
+        outcome = (dfsComplete || (complete && cutBound == -1U))
+                ? Impossible
+                : GaveUp;
     }
     return KSolveAStarResult(
         outcome,
         solution.GetMoves(),
         state._closedList.Size(),
         sharedMoveStorage.MoveTreeSize(),
-        sharedMoveStorage.FringeSize());
-    ;
+        sharedMoveStorage.FringeSize(),
+        expansionCount,
+        proven);
 }
 
 }   // namespace KSolveNames
\ No newline at end of file
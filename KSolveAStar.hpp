@@ -27,7 +27,9 @@
 #define KSOLVEASTAR_HPP
 
 #include "Game.hpp"		// for Game, Card, Pile, Move etc.
+#include "SolverOptions.hpp"     // for ClosedListKind, TieBreak
 namespace KSolveNames {
+class EndgameTable;
 // Solves the game of Klondike Solitaire for minimum moves if possible.
 // Returns a result code and a Moves vector.  The vector contains
 // the minimum solution if the code returned is SolvedMinimal. It will contain
@@ -38,37 +40,98 @@ namespace KSolveNames {
 // control this behavior to some degree by specifying MoveTreeLimit. 
 //
 // For some insight into how it works, look up the A* algorithm.
+//
+// With a focalFactor w above 1, it uses focal search instead.  Let
+// fMin be the lowest minimum move count of any leaf in the fringe.
+// Focal search expands the leaf with the fewest minimum moves left
+// among those whose minimum move counts are at most w*fMin, and it
+// stops once the best solution found has no more than w*fMin moves.
+// The result's _lowerBound gives the fMin it proved.  The code is
+// Solved unless the solution is also proven minimal.
+//
+// With partialExpansion, expanding a node stores only the children
+// whose minimum move counts equal the node's.  The node goes back into
+// the fringe with the lowest minimum move count among its other
+// children and is expanded again when that count comes up.  This
+// stores far fewer nodes that are never expanded, but it evaluates
+// the children of many nodes more than once.  It cannot be combined
+// with focal search, which needs every child in the fringe to choose
+// among.  Asking for both returns InvalidOptions without searching.
+//
+// With an EndgameTable, a node with few enough cards left is finished
+// by the table's own small search instead of being expanded, and
+// children's minimum move counts use the table's exact counts where
+// it knows them (except in partial expansion).  Those counts can
+// fall faster than one per move, so a child's count is never let
+// fall below its parent's.
+
+// InvalidOptions means the arguments asked for options that cannot
+// be combined.
+enum KSolveAStarCode {SolvedMinimal, Solved, Impossible, GaveUp, InvalidOptions};
 
-enum KSolveAStarCode {SolvedMinimal, Solved, Impossible, GaveUp};
 struct KSolveAStarResult
 {
     KSolveAStarCode _code;
     Moves _solution;
-    unsigned _branchCount;
-    unsigned _moveTreeSize;
-    unsigned _finalFringeStackSize;
+    size_t _branchCount;
+    size_t _moveTreeSize;
+    size_t _finalFringeStackSize;
+    size_t _expansionCount;     // number of leaves popped and expanded
+    unsigned _lowerBound;       // no solution has fewer moves than this
 
     KSolveAStarResult(KSolveAStarCode code, 
                 const Moves& moves, 
-                unsigned branchCount,
-                unsigned moveCount,
-                unsigned finalFringeStackSize)  noexcept
+                size_t branchCount,
+                size_t moveCount,
+                size_t finalFringeStackSize,
+                size_t expansionCount,
+                unsigned lowerBound)  noexcept
         : _code(code)
         , _solution(moves)
         , _branchCount(branchCount)
         , _moveTreeSize(moveCount)
         , _finalFringeStackSize(finalFringeStackSize)
+        , _expansionCount(expansionCount)
+        , _lowerBound(lowerBound)
         {}
 };
 KSolveAStarResult KSolveAStar(
         Game& gm, 			// The game to be played
-        unsigned MoveTreeLimit=12'000'000,// Give up if the size of the move tree
-                                        // exceeds this.
-        unsigned threads=0) noexcept;   // Use as many threads as the hardware will run together
+        size_t MoveTreeLimit=12'000'000,  // Give up if the number of nodes (moves)
+                                        // in the move tree exceeds this.
+        unsigned threads=0,             // Use as many threads as the hardware will run together
+        ClosedListKind closedList=ExactClosedList,
+        TieBreak tieBreak=LifoTieBreak,
+        bool portfolio=false,           // Use one of the threads for a
+                                        // depth-first branch-and-bound
+                                        // search (see KSolveGreedy.hpp)
+                                        // racing the A* search.
+        double focalFactor=1.0,         // If above 1, use focal search,
+                                        // which stops with a solution 
+                                        // no longer than this factor
+                                        // times _lowerBound.
+        bool partialExpansion=false,    // Use partial expansion A*: store
+                                        // only the children of each node 
+                                        // that are needed now.
+        EndgameTable* endgame=nullptr,  // If given, finish positions it
+                                        // covers from it rather than by
+                                        // searching (see EndgameTable.hpp),
+                                        // and use its exact move counts.
+        unsigned greedyBudget=20'000)   // Before searching, run KSolveGreedy()
+                                        // for up to this many expansions
+                                        // to find a solution to prune
+                                        // against.  0 skips it.
+        noexcept;
 
 unsigned DefaultThreads() noexcept;
 
 unsigned MinimumMovesLeft(const Game& game) noexcept;
+
+// Returns true if the tableau holds a pattern of cards that proves
+// the game cannot be won from its current position.  KSolveAStar()
+// checks the dealt game first and returns Impossible at once if it
+// finds one.
+bool IsDeadlocked(const Game& game) noexcept;
 }       // namespace KSolveNames
 
 
@@ -0,0 +1,182 @@
+#include "KSolveBeam.hpp"
+#include "GameStateMemory.hpp"      // for GameState, Hasher
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace KSolveNames {
+
+namespace {
+// A node is stored as the move from its parent, so a path is found by
+// walking back through the levels.
+struct BeamNode
+{
+    unsigned _parent;               // index of parent in its level
+    MoveSpec _mv;                   // the move from the parent
+    unsigned _stemBegin;            // this node's no-choice moves in
+    unsigned _stemEnd;              // its level's _stems
+};
+struct BeamLevel
+{
+    std::vector<BeamNode> _nodes;
+    std::vector<MoveSpec> _stems;   // made when the nodes are expanded
+};
+struct Child
+{
+    GameState _state;               // with moves made to reach the child
+    unsigned _parent;               // index of parent in its level
+    MoveSpec _mv;
+    unsigned _left;                 // MinimumMovesLeft() of the child
+    bool operator<(const Child& other) const noexcept
+    {
+        return _left < other._left
+            || (_left == other._left 
+                && _state.MoveCount() < other._state.MoveCount());
+    }
+};
+class BeamSearch
+{
+    Game _game;
+    unsigned _width;
+    // _levels.back() is the beam.
+    std::vector<BeamLevel> _levels;
+    // The moves from the deal to the node being expanded
+    MoveCounter<Moves> _path;
+    std::vector<Child> _children;
+    // The states of the nodes in the beam with their move counts
+    std::unordered_set<GameState,Hasher> _beamStates;
+    // The states of the children of the beam with their indices in _children
+    std::unordered_map<GameState,unsigned,Hasher> _childStates;
+    KSolveBeamResult _result{GaveUp, {}, 0, 0, 0, 0, 0, 0};
+
+    // Put in _path the moves from the deal to the beam's node at index,
+    // not counting its own no-choice moves.
+    void FindPath(unsigned index) noexcept
+    {
+        _path.clear();
+        // Collect the moves from the node back to the deal, then 
+        // reverse them.
+        for (unsigned level = _levels.size()-1; level > 0; --level) {
+            const BeamNode& node = _levels[level]._nodes[index];
+            _path.push_back(node._mv);
+            index = node._parent;
+            const BeamNode& parent = _levels[level-1]._nodes[index];
+            const auto& stems = _levels[level-1]._stems;
+            for (unsigned s = parent._stemEnd; s > parent._stemBegin; --s)
+                _path.push_back(stems[s-1]);
+        }
+        std::reverse(_path.begin(), _path.end());
+    }
+    // Restore _game to the state at the beam's node at index, then make
+    // its no-choice moves, adding them to _path and to the node.  
+    // Returns the first choice of moves.
+    QMoves Expand(unsigned index) noexcept
+    {
+        FindPath(index);
+        _game.Deal();
+        for (auto mv: _path)
+            _game.MakeMove(mv);
+        BeamLevel& level = _levels.back();
+        level._nodes[index]._stemBegin = level._stems.size();
+        QMoves avail;
+        while ((avail = _game.AvailableMoves(_path)).size() == 1) {
+            _path.push_back(avail[0]);
+            level._stems.push_back(avail[0]);
+            _game.MakeMove(avail[0]);
+        }
+        level._nodes[index]._stemEnd = level._stems.size();
+        return avail;
+    }
+    // Offer a child of the beam's node at parent to the next level
+    void AddChild(unsigned parent, MoveSpec mv, unsigned made) noexcept
+    {
+        ++_result._childCount;
+        const GameState state{_game, made};
+        if (auto it = _beamStates.find(state);
+                it != _beamStates.end() && it->MoveCount() <= made) {
+            ++_result._duplicateCount;
+            return;
+        }
+        const Child child{state, parent, mv, MinimumMovesLeft(_game)};
+        auto [it, inserted] = _childStates.emplace(state, _children.size());
+        if (inserted) {
+            _children.push_back(child);
+        } else {
+            ++_result._duplicateCount;
+            Child& other = _children[it->second];
+            if (made < other._state.MoveCount()) other = child;
+        }
+    }
+    // Make the best _width of _children the beam
+    void NextLevel() noexcept
+    {
+        if (_children.size() > _width) {
+            _result._droppedCount += _children.size() - _width;
+            std::nth_element(_children.begin(), _children.begin()+_width,
+                             _children.end());
+            _children.resize(_width);
+        }
+        BeamLevel next;
+        next._nodes.reserve(_children.size());
+        _beamStates.clear();
+        for (const Child& child: _children) {
+            next._nodes.push_back({child._parent, child._mv, 0, 0});
+            _beamStates.insert(child._state);
+        }
+        _levels.push_back(std::move(next));
+        _children.clear();
+        _childStates.clear();
+        _result._maxBeamSize = std::max(_result._maxBeamSize, 
+                                        _levels.back()._nodes.size());
+    }
+public:
+    BeamSearch(const Game& game, unsigned width) noexcept
+        : _game(game)
+        , _width(std::max(width, 1U))
+    {
+        _levels.emplace_back();
+        _levels.back()._nodes.push_back({0, MoveSpec(), 0, 0});
+    }
+    KSolveBeamResult Run() noexcept
+    {
+        unsigned shortest = -1U;
+        for (; _levels.back()._nodes.size() && _result._depth < MaxBeamDepth;
+                ++_result._depth) {
+            const unsigned beamSize = _levels.back()._nodes.size();
+            for (unsigned i = 0; i < beamSize; ++i) {
+                ++_result._expansionCount;
+                const QMoves avail = Expand(i);
+                if (avail.empty()) {
+                    if (_game.GameOver() && _path.MoveCount() < shortest) {
+                        shortest = _path.MoveCount();
+                        _result._solution.assign(_path.begin(), _path.end());
+                    }
+                    continue;
+                }
+                for (auto mv: avail) {
+                    _game.MakeMove(mv);
+                    AddChild(i, mv, _path.MoveCount() + mv.NMoves());
+                    _game.UnMakeMove(mv);
+                }
+            }
+            if (shortest != -1U) {
+                _result._code = Solved;
+                ++_result._depth;
+                break;
+            }
+            NextLevel();
+        }
+        if (_levels.back()._nodes.empty() && _result._droppedCount == 0)
+            _result._code = Impossible;
+        return std::move(_result);
+    }
+};
+}   // namespace
+
+KSolveBeamResult KSolveBeam(const Game& game, unsigned width) noexcept
+{
+    return BeamSearch(game, width).Run();
+}
+
+}   // namespace KSolveNames
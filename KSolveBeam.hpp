@@ -0,0 +1,49 @@
+// KSolveBeam.hpp declares a beam search Klondike Solitaire solver.
+// It is meant for sorting large numbers of deals quickly into those
+// it can solve, those it can prove impossible, and those that need
+// KSolveAStar().  Its memory use is set by its beam width and the
+// number of levels searched (at most MaxBeamDepth), not by the 
+// difficulty of the deal.  Each level keeps only a parent index
+// and a move for each of its nodes.  Its solutions are seldom minimal.
+
+#ifndef KSOLVEBEAM_HPP
+#define KSOLVEBEAM_HPP
+
+#include "Game.hpp"		            // for Game, Moves
+#include "KSolveAStar.hpp"          // for KSolveAStarCode
+namespace KSolveNames {
+
+constexpr unsigned MaxBeamDepth = 512;
+
+struct KSolveBeamResult
+{
+    KSolveAStarCode _code;      // Solved, Impossible, or GaveUp
+    Moves _solution;
+    unsigned _depth;            // number of levels searched
+    size_t _expansionCount;     // number of nodes expanded
+    size_t _childCount;         // number of children generated
+    size_t _duplicateCount;     // children dropped as duplicates
+    size_t _droppedCount;       // children dropped for lack of room
+    size_t _maxBeamSize;        // most nodes kept in any level
+};
+
+// Searches breadth first from the dealt game, keeping at each level
+// only the width nodes with the fewest minimum moves left
+// (MinimumMovesLeft()), breaking ties by fewest moves made.  A child
+// is dropped as a duplicate only if the same state is in its own
+// level or its parent's with no more moves made; there is no memory
+// of older levels.
+//
+// Stops at the first level at which some node is a win and returns
+// the shortest solution found at that level with code Solved.  If no
+// child was ever dropped for lack of room and the beam runs dry, the
+// game is Impossible.  Otherwise, after MaxBeamDepth levels or when
+// the beam runs dry, it returns GaveUp.  It never returns
+// SolvedMinimal.
+//
+// Runs in the calling thread. Run one per thread to sort many deals.
+KSolveBeamResult KSolveBeam(const Game& game, unsigned width = 1000) noexcept;
+
+}       // namespace KSolveNames
+
+#endif  // KSOLVEBEAM_HPP
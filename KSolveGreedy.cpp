@@ -0,0 +1,123 @@
+#include "KSolveGreedy.hpp"
+#include "KSolveAStar.hpp"          // for MinimumMovesLeft
+#include "GameStateMemory.hpp"      // for GameState, Hasher
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+namespace KSolveNames {
+
+namespace {
+class GreedySearch
+{
+    Game _game;
+    MoveCounter<Moves> _moves;
+    // The shortest path found to each state visited
+    std::unordered_set<GameState,Hasher> _visited;
+    CandidateSolution& _incumbent;
+    const std::atomic<bool>& _stop;
+    size_t _budget;
+    size_t _maxStates;
+    bool _cutOff{false};    // true if the search has been cut short
+
+    void Push(MoveSpec mv) noexcept
+    {
+        _game.MakeMove(mv);
+        _moves.push_back(mv);
+    }
+    void Pop() noexcept
+    {
+        _game.UnMakeMove(_moves.back());
+        _moves.pop_back();
+    }
+    // Returns true if no shorter path to the current state has been seen
+    bool IsShortPath() noexcept
+    {
+        const GameState state{_game, _moves.MoveCount()};
+        auto [it, inserted] = _visited.insert(state);
+        if (inserted) return true;
+        if (it->MoveCount() <= state.MoveCount()) return false;
+        _visited.erase(it);
+        _visited.insert(state);
+        return true;
+    }
+    // Search the subtree below the current node for solutions shorter
+    // than the incumbent.  Leaves _moves as it was on entry.
+    void Search() noexcept
+    {
+        const size_t depth = _moves.size();
+        QMoves avail;
+        while ((avail = _game.AvailableMoves(_moves)).size() == 1)
+            Push(avail[0]);
+        if (avail.empty() && _game.GameOver())
+            _incumbent.ReplaceIfShorter(_moves, _moves.MoveCount());
+        if (_budget == 0 || _visited.size() >= _maxStates || _stop)
+            _cutOff = true;
+        if (avail.size() && !_cutOff) {
+            --_budget;
+            struct Child {
+                MoveSpec _mv;
+                unsigned _minMoves;
+            };
+            std::vector<Child> children;
+            children.reserve(avail.size());
+            for (auto mv: avail) {
+                Push(mv);
+                if (IsShortPath())
+                    children.push_back({mv, _moves.MoveCount()+MinimumMovesLeft(_game)});
+                Pop();
+            }
+            std::stable_sort(children.begin(), children.end(), 
+                [](const Child& a, const Child& b) {return a._minMoves < b._minMoves;});
+            for (const Child& child: children) {
+                if (child._minMoves >= _incumbent.MoveCount()) break;
+                Push(child._mv);
+                Search();
+                Pop();
+            }
+        }
+        while (_moves.size() > depth)
+            Pop();
+    }
+public:
+    GreedySearch(const Game& game, 
+                 CandidateSolution& incumbent,
+                 const std::atomic<bool>& stop,
+                 size_t budget,
+                 size_t maxStates) noexcept
+        : _game(game)
+        , _incumbent(incumbent)
+        , _stop(stop)
+        , _budget(budget)
+        , _maxStates(maxStates)
+    {
+        _moves.clear();
+    }
+    // Returns true if the search was not cut short
+    bool Run() noexcept
+    {
+        _game.Deal();
+        IsShortPath();
+        Search();
+        return !_cutOff;
+    }
+};
+}   // namespace
+
+Moves KSolveGreedy(const Game& game, unsigned budget) noexcept
+{
+    CandidateSolution solution;
+    const std::atomic<bool> stop{false};
+    GreedySearch(game, solution, stop, budget, -1).Run();
+    return solution.GetMoves();
+}
+bool KSolveGreedy(const Game& game, 
+                  CandidateSolution& incumbent,
+                  const std::atomic<bool>& stop,
+                  size_t budget,
+                  size_t maxStates) noexcept
+{
+    return GreedySearch(game, incumbent, stop, budget, maxStates).Run();
+}
+
+}   // namespace KSolveNames
@@ -0,0 +1,38 @@
+// KSolveGreedy.hpp declares a fast greedy Klondike Solitaire solver.
+// It is meant to find some solution quickly, not a minimal one, so 
+// that KSolveAStar() can start with an upper bound on solution length.
+// Given time, though, it will find a minimal solution and prove it so.
+
+#ifndef KSOLVEGREEDY_HPP
+#define KSOLVEGREEDY_HPP
+
+#include "Game.hpp"		            // for Game, Moves
+#include "CandidateSolution.hpp"
+#include <atomic>
+namespace KSolveNames {
+
+// Searches depth first from the dealt game, trying the children of
+// each node in ascending order by minimum moves made plus minimum
+// moves left (MinimumMovesLeft()).  Once a solution is found, it
+// keeps looking for shorter ones, skipping any node that cannot lead
+// to one.  Stops after budget nodes have been expanded.  Returns the
+// shortest solution found, or an empty Moves if none was found.
+Moves KSolveGreedy(const Game& game, unsigned budget = 20'000) noexcept;
+
+// The same search as a member of a portfolio of search engines 
+// working on the same game.  It prunes against the move count of 
+// incumbent, the shortest solution any engine has found, and offers 
+// each solution it finds to incumbent.  It stops when stop becomes
+// true, after budget expansions, or when it has stored maxStates 
+// states.  Returns true if it searched the whole game tree, which 
+// proves incumbent minimal or, if incumbent is empty, the game
+// impossible.
+bool KSolveGreedy(const Game& game, 
+                  CandidateSolution& incumbent,
+                  const std::atomic<bool>& stop,
+                  size_t budget,
+                  size_t maxStates) noexcept;
+
+}       // namespace KSolveNames
+
+#endif  // KSOLVEGREEDY_HPP
@@ -0,0 +1,201 @@
+#include "KSolveNRPA.hpp"
+#include <atomic>
+#include <cmath>            // for std::exp
+#include <random>
+#include <thread>
+#include <utility>          // for std::as_const
+#include <vector>
+
+namespace KSolveNames {
+
+namespace {
+// A rollout that has not been won stops at the first choice of moves
+// after it has made this many.
+constexpr unsigned MaxRolloutMoves = 300;
+// The adaptation step size
+constexpr double Alpha = 1.0;
+
+// A policy gives a weight to each move code (see MoveCode()).
+using Policy = std::vector<double>;
+constexpr unsigned PolicySize = CardsPerDeck*PileCount;
+
+struct Rollout
+{
+    unsigned _score{0};
+    Moves _moves;
+};
+
+class NRPASearch
+{
+    Game _game;
+    MoveCounter<Moves> _moves;
+    std::mt19937_64 _rng;
+    const std::atomic<unsigned>& _bestRun;
+    unsigned _run;
+    unsigned _iterations;
+    size_t _rolloutCount{0};
+    bool _won{false};
+    // The codes and weights of the moves last weighed
+    std::vector<unsigned> _codes;
+    std::vector<double> _weights;
+
+    // Returns a number uniformly distributed in [0,1).  Unlike
+    // std::uniform_real_distribution, this gives the same sequence
+    // with every standard library.
+    double Random() noexcept
+    {
+        return (_rng() >> 11) * 0x1.0p-53;
+    }
+    // Returns a code for mv based on the first card it moves and
+    // the pile it moves to
+    unsigned MoveCode(MoveSpec mv) noexcept
+    {
+        _game.MakeMove(mv);
+        const Pile& to = std::as_const(_game).AllPiles()[mv.To()];
+        const unsigned code = to[to.size()-mv.NCards()].Value()*PileCount + mv.To();
+        _game.UnMakeMove(mv);
+        return code;
+    }
+    // More cards on the foundation score higher, then fewer moves
+    unsigned Score() const noexcept
+    {
+        unsigned onFoundation = 0;
+        for (const Pile& pile: _game.Foundation())
+            onFoundation += pile.size();
+        return (onFoundation+1)*1024 - _moves.MoveCount();
+    }
+    // Compute the code and weight of each move in avail under policy
+    // into _codes and _weights.  Returns the sum of the weights.
+    double Weigh(const QMoves& avail, const Policy& policy) noexcept
+    {
+        _codes.resize(avail.size());
+        _weights.resize(avail.size());
+        double sum = 0;
+        for (unsigned i = 0; i < avail.size(); ++i) {
+            _codes[i] = MoveCode(avail[i]);
+            _weights[i] = std::exp(policy[_codes[i]]);
+            sum += _weights[i];
+        }
+        return sum;
+    }
+    // Play a game from the deal, choosing moves at random as weighted by policy
+    Rollout Play(const Policy& policy) noexcept
+    {
+        ++_rolloutCount;
+        _game.Deal();
+        _moves.clear();
+        QMoves avail;
+        while ((avail = _game.AvailableMoves(_moves)).size()
+                && (avail.size() == 1 || _moves.MoveCount() < MaxRolloutMoves)) {
+            unsigned i = 0;
+            if (avail.size() > 1) {
+                double r = Random() * Weigh(avail, policy);
+                while (i+1 < avail.size() && (r -= _weights[i]) >= 0)
+                    ++i;
+            }
+            _game.MakeMove(avail[i]);
+            _moves.push_back(avail[i]);
+        }
+        _won = _game.GameOver();
+        return Rollout{Score(), Moves(_moves.begin(), _moves.end())};
+    }
+    // Make the moves in best more likely under policy and the
+    // alternatives to them less likely
+    void Adapt(Policy& policy, const Moves& best) noexcept
+    {
+        Policy next = policy;
+        _game.Deal();
+        _moves.clear();
+        for (auto mv: best) {
+            const QMoves avail = _game.AvailableMoves(_moves);
+            if (avail.size() > 1) {
+                const double sum = Weigh(avail, policy);
+                for (unsigned i = 0; i < avail.size(); ++i)
+                    next[_codes[i]] -= Alpha*_weights[i]/sum;
+                next[MoveCode(mv)] += Alpha;
+            }
+            _game.MakeMove(mv);
+            _moves.push_back(mv);
+        }
+        policy = std::move(next);
+    }
+    // True if this run has won or a lower-numbered one has
+    bool Stop() const noexcept
+    {
+        return _won || _bestRun.load(std::memory_order_relaxed) < _run;
+    }
+    Rollout Search(unsigned level, Policy policy) noexcept
+    {
+        if (level == 0) return Play(policy);
+        Rollout best;
+        for (unsigned i = 0; i < _iterations && !Stop(); ++i) {
+            Rollout result = Search(level-1, policy);
+            if (result._score >= best._score)
+                best = std::move(result);
+            if (_won) break;
+            Adapt(policy, best._moves);
+        }
+        return best;
+    }
+public:
+    NRPASearch(const Game& game,
+               std::uint64_t seed,
+               unsigned run,
+               const std::atomic<unsigned>& bestRun,
+               unsigned iterations) noexcept
+        : _game(game)
+        , _rng(seed + 0x9e3779b97f4a7c15ULL*(run+1))
+        , _bestRun(bestRun)
+        , _run(run)
+        , _iterations(iterations)
+        {}
+    Rollout Run(unsigned level) noexcept
+    {
+        return Search(level, Policy(PolicySize, 0.0));
+    }
+    bool Won() const noexcept {return _won;}
+    size_t RolloutCount() const noexcept {return _rolloutCount;}
+};
+}   // namespace
+
+KSolveNRPAResult KSolveNRPA(const Game& game,
+                            std::uint64_t seed,
+                            unsigned nThreads,
+                            unsigned runs,
+                            unsigned level,
+                            unsigned iterations) noexcept
+{
+    if (nThreads == 0)
+        nThreads = DefaultThreads();
+    nThreads = std::max(1U, std::min(nThreads, runs));
+
+    std::atomic<unsigned> nextRun{0};
+    std::atomic<unsigned> bestRun{-1U};
+    std::atomic<size_t> rolloutCount{0};
+    std::vector<Moves> solutions(runs);
+    auto worker = [&] {
+        for (unsigned run; (run = nextRun++) < runs && run < bestRun; ) {
+            NRPASearch search(game, seed, run, bestRun, iterations);
+            Rollout result = search.Run(level);
+            rolloutCount += search.RolloutCount();
+            if (search.Won()) {
+                solutions[run] = std::move(result._moves);
+                unsigned prior = bestRun;
+                while (run < prior && !bestRun.compare_exchange_weak(prior, run)) {}
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads-1);
+    for (unsigned t = 0; t < nThreads-1; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread: threads)
+        thread.join();
+
+    if (bestRun == -1U)
+        return KSolveNRPAResult{GaveUp, {}, rolloutCount, -1U};
+    return KSolveNRPAResult{Solved, std::move(solutions[bestRun]), rolloutCount, bestRun};
+}
+
+}   // namespace KSolveNames
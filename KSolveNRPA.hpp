@@ -0,0 +1,47 @@
+// KSolveNRPA.hpp declares a Klondike Solitaire solver using Nested
+// Rollout Policy Adaptation (NRPA), a Monte Carlo search.  It is
+// meant to show quickly that a deal is winnable, particularly one
+// for which KSolveAStar() gives up.  Its solutions are seldom minimal,
+// and it cannot prove a deal impossible.
+
+#ifndef KSOLVENRPA_HPP
+#define KSOLVENRPA_HPP
+
+#include "Game.hpp"		            // for Game, Moves
+#include "KSolveAStar.hpp"          // for KSolveAStarCode
+#include <cstdint>
+namespace KSolveNames {
+
+struct KSolveNRPAResult
+{
+    KSolveAStarCode _code;      // Solved or GaveUp
+    Moves _solution;
+    size_t _rolloutCount;       // number of rollouts played by all runs
+    unsigned _run;              // the run that found _solution
+};
+
+// A rollout plays from the deal to the end of the game, choosing
+// among the moves AvailableMoves() offers at random, weighting each
+// by a policy.  A move is known to the policy by the card it moves
+// and the pile it moves to.  A level-n search does iterations
+// level-(n-1) searches, and after each, adapts its policy toward the
+// best sequence of moves found so far.  A level-0 search is a
+// rollout.  A rollout is scored by the number of cards it puts on the
+// foundation, then by fewest moves.
+//
+// A run is a level-level search with an empty starting policy and
+// its own random number generator seeded from seed and the run
+// number.  The runs are shared among threads.  A run stops at its
+// first win.  The solution returned is that of the lowest-numbered
+// run that wins, so the result depends only on the arguments, not on
+// the number of threads or their timing.
+KSolveNRPAResult KSolveNRPA(const Game& game,
+                            std::uint64_t seed = 1,
+                            unsigned threads = 0,   // 0: DefaultThreads()
+                            unsigned runs = 8,
+                            unsigned level = 2,
+                            unsigned iterations = 100) noexcept;
+
+}       // namespace KSolveNames
+
+#endif  // KSOLVENRPA_HPP
@@ -1,19 +1,136 @@
 #include "MoveStorage.hpp"
+#include <bit>              // for std::popcount
 #include <iostream>
 
 namespace KSolveNames {
 
-void SharedMoveStorage::Start(size_t moveTreeSizeLimit, unsigned minMoves) noexcept
+void SharedMoveStorage::Start(size_t moveTreeSizeLimit, unsigned minMoves, 
+                              TieBreak tieBreak, double focalFactor) noexcept
 {
+    _focalFactor = focalFactor;
+    _byMovesLeft = tieBreak == LowHTieBreak || focalFactor > 1.0;
     _moveTreeSizeLimit = moveTreeSizeLimit;
-    _moveTree.reserve(moveTreeSizeLimit+1000);
+    _moveTree.Reserve(moveTreeSizeLimit+1000);
     _initialMinMoves = minMoves;
     _firstTime = true;
+    _gcThreshold = moveTreeSizeLimit - moveTreeSizeLimit/8;
+}
+void SharedMoveStorage::BeginWork() noexcept
+{
+    std::unique_lock<Mutex> lock(_gcMutex);
+    _gcCondition.wait(lock, [this] {return !_gcPending;});
+    ++_busyWorkers;
+}
+void SharedMoveStorage::EndWork() noexcept
+{
+    Guard callisto(_gcMutex);
+    --_busyWorkers;
+    if (_gcPending && _busyWorkers == 0)
+        _gcCondition.notify_all();
+}
+void SharedMoveStorage::CollectGarbageIfNeeded() noexcept
+{
+    if (_moveTree.Size() < _gcThreshold) return;
+    std::unique_lock<Mutex> lock(_gcMutex);
+    if (_gcPending) {
+        // Another thread is collecting
+        _gcCondition.wait(lock, [this] {return !_gcPending;});
+        return;
+    }
+    if (_moveTree.Size() < _gcThreshold) return;
+    _gcPending = true;
+    _gcCondition.wait(lock, [this] {return _busyWorkers == 0;});
+    CollectGarbage();
+    // Collect again when half the remaining headroom is used.  If 
+    // collecting freed too little to be worth doing again, don't.
+    const size_t live = _moveTree.Size();
+    const size_t headroom = _moveTreeSizeLimit - std::min(live,_moveTreeSizeLimit);
+    _gcThreshold = (headroom < _moveTreeSizeLimit/8) 
+        ? -1 
+        : live + headroom/2;
+    _gcPending = false;
+    _gcCondition.notify_all();
+}
+// Mark the nodes some fringe leaf leads back to, slide them down
+// to fill the gaps left by the others, and adjust all the indices.
+void SharedMoveStorage::CollectGarbage() noexcept
+{
+    _fringe.ForEach([&](MoveNode& leaf) {
+        _moveTree.Mark(leaf._prevNode);
+    });
+    _moveTree.Compact();
+    _fringe.ForEach([&](MoveNode& leaf) {
+        leaf._prevNode = _moveTree.NewIndex(leaf._prevNode);
+    });
+    _moveTree.EndCollection();
+    ++_gcCount;
+}
+// Mark node and all its ancestors, including the links to the
+// first node of each chain
+void CompactMoveTree::Mark(NodeX node) noexcept
+{
+    if (_liveMoves.empty()) {
+        const size_t nWords = (_cells.size()+63)/64;
+        _liveMoves.assign(nWords, 0);
+        _keep.assign(nWords, 0);
+    }
+    for (; node != NullNode && !IsSet(_liveMoves, node); node = Parent(node)) {
+        Set(_liveMoves, node);
+        Set(_keep, node);
+        if (TaggedMove(node).Tagged()) {
+            for (unsigned i = 1; i <= LinkCells; ++i)
+                Set(_keep, node-i);
+        }
+    }
+}
+// Since a node's parent always precedes it, sliding cells down in
+// order never overwrites a cell not yet moved.  A node that is not
+// the first of its chain keeps its implicit parent, since that
+// parent is its ancestor, so it has been kept and moved just before it.
+void CompactMoveTree::Compact() noexcept
+{
+    _keepBase.resize(_keep.size());
+    NodeX count = 0;
+    for (size_t w = 0; w < _keep.size(); ++w) {
+        _keepBase[w] = count;
+        count += std::popcount(_keep[w]);
+    }
+    size_t next = 0;
+    size_t nodes = 0;
+    for (NodeX i = 0; i < _cells.size(); ++i) {
+        if (!IsSet(_liveMoves, i)) continue;
+        ++nodes;
+        const Cell cell = _cells[i];
+        if (TaggedMove(i).Tagged()) {
+            PutLink(next, NewIndex(Link(i)));
+            next += LinkCells;
+        }
+        _cells[next++] = cell;
+    }
+    assert(next == count);
+    _cells.resize(next);
+    _nodeCount = nodes;
+}
+NodeX CompactMoveTree::NewIndex(NodeX node) const noexcept
+{
+    if (node == NullNode) return node;
+    const std::uint64_t below = (std::uint64_t(1) << (node%64)) - 1;
+    return _keepBase[node/64] + std::popcount(_keep[node/64] & below);
+}
+void CompactMoveTree::EndCollection() noexcept
+{
+    _liveMoves = {};
+    _keep = {};
+    _keepBase = {};
 }
 MoveStorage::MoveStorage(SharedMoveStorage& shared) noexcept
     : _shared(shared)
     , _startSize(0)
     {}
+MoveStorage::~MoveStorage() noexcept
+{
+    if (_busy) _shared.EndWork();
+}
 void MoveStorage::PushStem(MoveSpec move) noexcept
 {
     // This is where the program fails when XYZ_Test give false negatives.
@@ -24,13 +141,17 @@ void MoveStorage::PushStem(MoveSpec move) noexcept
     }
     _currentSequence.push_back(move);
 }
-void MoveStorage::PushBranch(MoveSpec mv, unsigned nMoves) noexcept
+void MoveStorage::PushBranch(MoveSpec mv, unsigned nMoves, unsigned movesLeft) noexcept
 {
-    assert(_shared._initialMinMoves <= nMoves);
-    _branches.emplace_back(mv,nMoves-_shared._initialMinMoves);
+    _branches.emplace_back(mv,_shared.FringeIndex(nMoves,movesLeft));
 }
-void MoveStorage::ShareMoves() noexcept
+void MoveStorage::ShareMoves(unsigned bound) noexcept
 {
+    // A solution may have been found since the branches were pushed.
+    auto tooLong = [&](const MovePair& br) 
+        {return _shared.MinMoves(br._index) >= bound;};
+    _branches.erase(std::remove_if(_branches.begin(), _branches.end(), tooLong),
+                    _branches.end());
     // If _branches is empty, a dead end has been reached.  There
     // is no need to store any stem nodes that led to it.
     if (_branches.size()) {
@@ -43,37 +164,64 @@ void MoveStorage::ShareMoves() noexcept
 // Returns move tree index of last stem node
 NodeX MoveStorage::UpdateMoveTree() noexcept
 {
-    NodeX stemEnd = _leaf._prevNode;
-    {
-        Guard rupert(_shared._moveTreeMutex);
-        // Copy all the stem moves into the move tree.
-        for (auto m: _currentSequence | views::drop(_startSize))
-        {
-            // Each stem node points to the previous node.
-            _shared._moveTree.emplace_back(m, stemEnd);
-            stemEnd =  _shared._moveTree.size() - 1;
-        }
-    }
-    return stemEnd;
+    Guard rupert(_shared._moveTreeMutex);
+    // Copy all the stem moves into the move tree.
+    return _shared._moveTree.AppendChain(_leaf._prevNode,
+                                         _currentSequence | views::drop(_startSize));
 } 
 void MoveStorage::UpdateFringe(NodeX stemEnd) noexcept
 {
-    ranges::sort(_branches,ranges::greater(),&MovePair::_offset);  // descending by offset
+    ranges::sort(_branches,ranges::greater(),&MovePair::_index);  // descending by index
     auto & fringe = _shared._fringe;
     for (const auto &br: _branches) {
-        fringe.Emplace(br._offset, br._mv, stemEnd);
+        fringe.Emplace(br._index, br._mv, stemEnd);
+    }
+}
+std::optional<std::pair<unsigned,MoveNode>> 
+    SharedMoveStorage::PopFocal(unsigned bound, unsigned& fringeMin) noexcept
+{
+    for (unsigned nTries = 0; nTries < 5; ++nTries) {
+        const unsigned first = _fringe.FirstNonEmpty();
+        if (first < FringeIndices) {
+            const unsigned fMin = MinMoves(first);
+            const unsigned fMax = std::max(fMin, 
+                std::min(unsigned(_focalFactor*fMin), bound-1));
+            fringeMin = fMin;
+            for (unsigned h = 0; h < HLevels; ++h) {
+                for (unsigned f = fMin; f <= fMax; ++f) {
+                    const unsigned index = FringeIndex(f, h);
+                    if (_fringe.IsNonEmpty(index)) {
+                        auto result = _fringe.PopFrom(index);
+                        if (result) return result;
+                    }
+                }
+            }
+        }
+        std::this_thread::yield();
     }
+    return std::nullopt;
 }
-unsigned MoveStorage::PopNextMoveSequence( ) noexcept
+unsigned MoveStorage::PopNextMoveSequence(unsigned bound) noexcept
 {
+    if (_busy) _shared.EndWork();
+    _shared.CollectGarbageIfNeeded();
+    _shared.BeginWork();
+    _busy = true;
     if (_shared._firstTime) {
         _shared._firstTime = false;
+        _fringeMinMoves = _shared._initialMinMoves;
         return _shared._initialMinMoves;
     }
-    auto nextLeaf = _shared._fringe.Pop();
+    std::optional<std::pair<unsigned,MoveNode>> nextLeaf;
+    if (_shared._focalFactor > 1.0) {
+        nextLeaf = _shared.PopFocal(bound, _fringeMinMoves);
+    } else {
+        nextLeaf = _shared._fringe.Pop();
+        if (nextLeaf) _fringeMinMoves = _shared.MinMoves(nextLeaf->first);
+    }
     if (nextLeaf) {
         _leaf = nextLeaf->second;
-        return nextLeaf->first+_shared._initialMinMoves;
+        return _shared.MinMoves(nextLeaf->first);
     } else {
         return 0;     // last time for this thread
     }
@@ -82,11 +230,11 @@ void MoveStorage::LoadMoveSequence() noexcept
 {
     // Follow the links to recover all the moves in a sequence in reverse order.
     _currentSequence.clear();
+    const CompactMoveTree& tree = _shared._moveTree;
     for    (NodeX node = _leaf._prevNode; 
-            node != -1U; 
-            node = _shared._moveTree[node]._prevNode){
-        const MoveSpec &mv = _shared._moveTree[node]._move;
-        _currentSequence.push_front(mv);
+            node != NullNode; 
+            node = tree.Parent(node)){
+        _currentSequence.push_front(tree.Move(node));
     }
     _startSize = _currentSequence.size();
     if (!_leaf._move.IsDefault()) 
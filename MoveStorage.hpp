@@ -1,12 +1,59 @@
 #include "Game.hpp"
+#include "SolverOptions.hpp"     // for TieBreak
 #include "frystl/mf_vector.hpp"
 #include "frystl/static_deque.hpp"
+#include "SpillFile.hpp"
+#include <atomic>
+#include <bit>              // for std::bit_cast
+#include <condition_variable>
+#include <memory>           // for std::unique_ptr
+#include <optional>
 #include <mutex>          	// for std::mutex, std::lock_guard
 #include <thread>           // for std::this_thread::yield()
 
 namespace KSolveNames {
 
+// Move tree node indices.  By default they are 32 bits wide, which 
+// limits the move tree to about 4.29 billion nodes.  Define
+// KSOLVE_WIDE_NODE_INDEX (see the CMake option of the same name)
+// to make them 40 bits wide.
+#ifdef KSOLVE_WIDE_NODE_INDEX
+using NodeX = std::uint64_t;
+constexpr unsigned NodeXBits = 40;
+#else
 using NodeX = std::uint32_t;
+constexpr unsigned NodeXBits = 32;
+#endif
+// The null link that ends every chain in the move tree
+constexpr NodeX NullNode = NodeX(-1) >> (8*sizeof(NodeX) - NodeXBits);
+
+#ifdef KSOLVE_WIDE_NODE_INDEX
+// A NodeX stored in just NodeXBits/8 bytes with no alignment
+// requirement, so that it does not push MoveNode to 16 bytes.
+class PackedNodeX
+{
+    std::uint8_t _bytes[NodeXBits/8];
+public:
+    PackedNodeX() = default;
+    PackedNodeX(NodeX x) noexcept
+    {
+        for (auto& byte: _bytes) {
+            byte = x & 0xff;
+            x >>= 8;
+        }
+    }
+    operator NodeX() const noexcept
+    {
+        NodeX result = 0;
+        for (unsigned i = sizeof(_bytes); i-- > 0; )
+            result = result << 8 | _bytes[i];
+        return result;
+    }
+};
+#else
+using PackedNodeX = NodeX;
+#endif
+
 using Mutex = std::mutex;
 using Guard = std::lock_guard<Mutex>;
 
@@ -18,15 +65,47 @@ class ShareableIndexedPriorityQueue {
     // It is efficient if the I values are all small integers.
     // I must be an unsigned type.
     //
-    // Pairs sharing the same I values are returned in LIFO order. 
+    // Pairs sharing the same I values are returned in LIFO order,
+    // except when spilling is enabled (see EnableSpill()).
 private:
     using StackT = mf_vector<V,1024>;
+    // Where a batch of values has been written to _spillFile
+    struct Segment {
+        std::uint64_t _offset;
+        size_t _count;
+    };
     Mutex _mutex;
     struct ProtectedStackT {
         Mutex _mutex;
         StackT _stack;
+        std::vector<Segment> _spilled;
+        std::atomic<size_t> _spilledCount{0};
     };
-    static_vector<ProtectedStackT, Sz>_stacks;
+    // The stacks live on the heap, since Sz may be large.
+    using StacksT = static_vector<ProtectedStackT, Sz>;
+    std::unique_ptr<StacksT> _pStacks {std::make_unique<StacksT>()};
+    StacksT& _stacks {*_pStacks};
+    // No stack below this index is known to be non-empty
+    std::atomic<I> _scanStart{0};
+    // Spilling (see EnableSpill())
+    std::unique_ptr<SpillFile> _spillFile;
+    std::atomic<I> _lastPopIndex{0};
+    I _spillDistance{3};
+    std::atomic<bool> _spillOff{false};     // a write has failed
+    std::atomic<bool> _spillLost{false};    // a read has failed
+    static constexpr size_t SpillBatch = 16*1024;
+
+    static bool NonEmpty(const ProtectedStackT & elem) noexcept
+    {
+        return !elem._stack.empty() || elem._spilledCount;
+    }
+    // Make sure Pop() will not start its search above index.
+    void LowerScanStart(I index) noexcept
+    {
+        I start = _scanStart;
+        while (index < start && !_scanStart.compare_exchange_weak(start, index)) {}
+    }
+
     void inline UpsizeTo(I newSize) noexcept
     {
         if (_stacks.size() < newSize) {
@@ -35,8 +114,51 @@ private:
                 _stacks.resize(newSize);
         }
     }
+    // Move all of a stack's values to the spill file.  If they cannot
+    // be written, keep them and stop spilling.  Caller must hold the
+    // stack's lock.
+    void Spill(ProtectedStackT& pStack) noexcept
+    {
+        std::vector<V> batch(pStack._stack.begin(), pStack._stack.end());
+        std::uint64_t offset;
+        if (!_spillFile->Append(batch.data(), batch.size()*sizeof(V), offset)) {
+            _spillOff = true;
+            return;
+        }
+        pStack._spilled.push_back(Segment{offset, batch.size()});
+        pStack._spilledCount += batch.size();
+        pStack._stack.clear();
+    }
+    // Move the most recently spilled values of a stack back into
+    // main memory.  If they cannot be read, they are lost, and
+    // SpillFailed() becomes true.  Caller must hold the stack's lock.
+    void Unspill(ProtectedStackT& pStack) noexcept
+    {
+        const Segment segment = pStack._spilled.back();
+        pStack._spilled.pop_back();
+        pStack._spilledCount -= segment._count;
+        std::vector<V> batch(segment._count);
+        if (!_spillFile->Read(segment._offset, batch.data(), segment._count*sizeof(V))) {
+            _spillLost = true;
+            return;
+        }
+        for (const V& value: batch)
+            pStack._stack.push_back(value);
+    }
 
 public:
+    // Allow stacks whose indices exceed that of the last
+    // pair popped by more than spillDistance to move their contents 
+    // to a temporary file in batches of SpillBatch values.  
+    // Returns false if the file cannot be created.
+    bool EnableSpill(I spillDistance = 3) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<V>);
+        _spillDistance = spillDistance;
+        _spillFile = std::make_unique<SpillFile>();
+        if (!_spillFile->IsOpen()) _spillFile.reset();
+        return bool(_spillFile);
+    }
     template <class... Args>
     void Emplace(I index, Args &&...args) noexcept
     {
@@ -44,52 +166,129 @@ public:
         auto& pStack = _stacks[index];
         Guard esperanto(pStack._mutex);
         pStack._stack.emplace_back(std::forward<Args>(args)...);
+        if (_spillFile && !_spillOff
+                && pStack._stack.size() >= SpillBatch
+                && index > _lastPopIndex + _spillDistance) {
+            Spill(pStack);
+        }
+        LowerScanStart(index);
     }
     void Push(I index, const V& value) noexcept
     {
         Emplace(index, value);
     }
+    // Something like the Uncertainty Principle applies here: in a multithreaded
+    // environment, since a stack may become empty or non-empty 
+    // at any instant, which one is the first non-empty one may depend on 
+    // which thread is looking and exactly when. It is thus impossible to
+    // be certain what the correct return value is without stopping the running
+    // of other threads. No attempt is made here to
+    // eliminate that problem. In this application, it does no harm.   
     std::optional<std::pair<I,V>> Pop() noexcept
     {
-        // Something like the Uncertainty Principle applies here: in a multithreaded
-        // environment, since a stack may become empty or non-empty 
-        // at any instant, which one is the first non-empty one may depend on 
-        // which thread is looking and exactly when. It is thus impossible to
-        // be certain what the correct return value is without stopping the running
-        // of other threads. No attempt is made here to
-        // eliminate that problem. In this application, it does no harm.   
         std::optional<std::pair<I,V>> result;
         for (unsigned nTries = 0; !result && nTries < 5; ++nTries) 
         {
-            auto nonEmpty = [] (const ProtectedStackT & elem) 
-                {return !elem._stack.empty();};
-            unsigned index = ranges::find_if(_stacks,nonEmpty) - _stacks.begin();
-            unsigned size = _stacks.size();
-
-            if (index < size) {
-                StackT & stack = _stacks[index]._stack;
-                Guard methuselah(_stacks[index]._mutex);
-                if (stack.size()) {
-                    result = std::make_pair(index,stack.back());
-                    stack.pop_back();
-                }
-            }
+            const unsigned index = FirstNonEmpty();
+            if (index < Sz)
+                result = PopFrom(index);
             if (!result) std::this_thread::yield();
         }
         return result;
     }
+    // Returns the index of the first stack that appears to be non-empty,
+    // or Sz if none does.
+    unsigned FirstNonEmpty() noexcept
+    {
+        I start = _scanStart;
+        const unsigned size = _stacks.size();
+        const unsigned index = std::find_if(_stacks.begin()+std::min<unsigned>(start,size), 
+                                            _stacks.end(), NonEmpty) - _stacks.begin();
+        if (start < index && _scanStart.compare_exchange_strong(start, index)) {
+            // A stack in the range just skipped may have been pushed 
+            // onto after it was checked but before _scanStart was
+            // raised, in which case the push did not lower it.
+            auto skipped = std::find_if(_stacks.begin()+start, 
+                                        _stacks.begin()+index, NonEmpty);
+            if (skipped != _stacks.begin()+index)
+                LowerScanStart(skipped - _stacks.begin());
+        }
+        return (index < size) ? index : Sz;
+    }
+    // Returns true if the stack at index appears to be non-empty.
+    bool IsNonEmpty(I index) const noexcept
+    {
+        return index < _stacks.size() && NonEmpty(_stacks[index]);
+    }
+    // Pop the top value of the stack at index if it is not empty.
+    std::optional<std::pair<I,V>> PopFrom(I index) noexcept
+    {
+        std::optional<std::pair<I,V>> result;
+        if (index < _stacks.size()) {
+            auto& pStack = _stacks[index];
+            StackT & stack = pStack._stack;
+            Guard methuselah(pStack._mutex);
+            if (stack.empty() && pStack._spilled.size()) 
+                Unspill(pStack);
+            if (stack.size()) {
+                result = std::make_pair(index,stack.back());
+                stack.pop_back();
+                _lastPopIndex = index;
+            }
+        }
+        return result;
+    }
+    // Remove all pairs whose I values are index or more.  Their
+    // stacks' memory blocks are returned to the heap.
+    void Truncate(I index) noexcept
+    {
+        for (unsigned i = index; i < _stacks.size(); ++i) {
+            auto& pStack = _stacks[i];
+            Guard pilate(pStack._mutex);
+            pStack._stack.clear();
+            pStack._spilled.clear();
+            pStack._spilledCount = 0;
+        }
+    }
+    // Apply f to every value in the queue, including those spilled
+    // to disk.  f may modify its argument.  No other thread may use 
+    // the queue meanwhile.
+    template <class F>
+    void ForEach(F f) noexcept
+    {
+        for (auto& pStack: _stacks) {
+            for (V& value: pStack._stack)
+                f(value);
+            for (const Segment& segment: pStack._spilled) {
+                std::vector<V> batch(segment._count);
+                const size_t nBytes = segment._count*sizeof(V);
+                if (!_spillFile->Read(segment._offset, batch.data(), nBytes)) {
+                    _spillLost = true;
+                    continue;
+                }
+                for (V& value: batch)
+                    f(value);
+                if (!_spillFile->Overwrite(segment._offset, batch.data(), nBytes))
+                    _spillLost = true;
+            }
+        }
+    }
+    // Returns true if values spilled to disk could not be read back
+    // or rewritten, so some have been lost or left stale.
+    bool SpillFailed() const noexcept {return _spillLost;}
     // Returns total size.  Not accurate when threads are making changes.
-    unsigned Size() const noexcept
+    size_t Size() const noexcept
     {
-        return std::accumulate(_stacks.begin(), _stacks.end(), 0U, 
-            [](auto accum, auto& pStack){return accum + pStack._stack.size();});
+        return std::accumulate(_stacks.begin(), _stacks.end(), size_t(0), 
+            [](auto accum, auto& pStack)
+                {return accum + pStack._stack.size() + pStack._spilledCount;});
     }
 };
 
 struct MoveNode
 {
     MoveSpec _move;
-    NodeX _prevNode{-1U};
+    PackedNodeX _prevNode{NullNode};
 
     MoveNode() = default;
     MoveNode(const MoveSpec& mv, NodeX prevNode) noexcept
@@ -97,29 +296,213 @@ struct MoveNode
         , _prevNode(prevNode)
         {}
 };
+static_assert(sizeof(MoveNode) <= 10, "MoveNode should fit in 10 bytes");
+
+// The move tree.  Each thread's trip through the main loop appends
+// a chain of stem moves, each of whose parent is the node before it,
+// except the first, whose parent may be anywhere.  So the tree is
+// stored as an array of 4-byte cells, one per move, and only the
+// first move of a chain gets a link to its parent.  It is tagged
+// (see MoveSpec::Tagged()) and preceded by LinkCells cells holding
+// its parent's index.
+//
+// Appending must be serialized, but nodes may be read concurrently 
+// with appending.
+class CompactMoveTree
+{
+    using Cell = std::uint32_t;
+    static constexpr unsigned LinkCells = (NodeXBits + 31) / 32;
+    static_assert(sizeof(MoveSpec) == sizeof(Cell));
+    std::vector<Cell> _cells;
+    std::atomic<size_t> _nodeCount{0};      // cells that hold moves
+
+    // Set during garbage collection (see Mark())
+    std::vector<std::uint64_t> _liveMoves;  // bit i set if cell i is a live move
+    std::vector<std::uint64_t> _keep;       // ... if cell i is to be kept
+    std::vector<NodeX> _keepBase;           // number of kept cells below 64*w
+
+    bool IsSet(const std::vector<std::uint64_t>& bits, NodeX i) const noexcept
+    {
+        return bits[i/64] >> (i%64) & 1;
+    }
+    static void Set(std::vector<std::uint64_t>& bits, NodeX i) noexcept
+    {
+        bits[i/64] |= std::uint64_t(1) << (i%64);
+    }
+    MoveSpec TaggedMove(NodeX node) const noexcept
+    {
+        return std::bit_cast<MoveSpec>(_cells[node]);
+    }
+    // Returns the link stored just before the first node of a chain
+    NodeX Link(NodeX node) const noexcept
+    {
+        std::uint64_t result = 0;
+        for (unsigned i = LinkCells; i > 0; --i)
+            result = result << 32 | _cells[node-i];
+        return NodeX(result);
+    }
+    // Stores a link at the next LinkCells cells starting at index at
+    void PutLink(size_t at, NodeX link) noexcept
+    {
+        for (unsigned i = LinkCells; i-- > 0; ) {
+            _cells[at+i] = Cell(link);
+            link = NodeX(std::uint64_t(link) >> 32);
+        }
+    }
+public:
+    // Reserve room for nNodes nodes, however they are chained, so
+    // that appending never moves the cells while others read them.
+    void Reserve(size_t nNodes) noexcept    {_cells.reserve(nNodes*(1+LinkCells));}
+    // Returns the number of nodes (moves) stored
+    size_t Size() const noexcept            {return _nodeCount.load(std::memory_order_relaxed);}
+    // Returns the number of cells in use, including links
+    size_t CellCount() const noexcept       {return _cells.size();}
+    MoveSpec Move(NodeX node) const noexcept
+    {
+        MoveSpec result = TaggedMove(node);
+        result.Tagged(false);
+        return result;
+    }
+    NodeX Parent(NodeX node) const noexcept
+    {
+        return TaggedMove(node).Tagged() ? Link(node) : node - 1;
+    }
+    // Append the moves in a range as a chain starting at a child 
+    // of parent.  Returns the index of the last one.
+    template <class Range>
+    NodeX AppendChain(NodeX parent, const Range& moves) noexcept
+    {
+        bool first = true;
+        for (MoveSpec mv: moves) {
+            if (first) {
+                _cells.resize(_cells.size() + LinkCells);
+                PutLink(_cells.size() - LinkCells, parent);
+                mv.Tagged(true);
+                first = false;
+            }
+            _cells.push_back(std::bit_cast<Cell>(mv));
+            _nodeCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return first ? parent : _cells.size() - 1;
+    }
+
+    // Garbage collection.  Call Mark() for every node to be kept,
+    // then Compact() to remove all other nodes.  Then NewIndex(n) 
+    // returns the index a node formerly at index n now has.  Call
+    // EndCollection() to free the memory used.
+    void Mark(NodeX node) noexcept;
+    void Compact() noexcept;
+    NodeX NewIndex(NodeX node) const noexcept;
+    void EndCollection() noexcept;
+};
 
 class SharedMoveStorage
 {
 private:
     size_t _moveTreeSizeLimit;
-    std::vector<MoveNode> _moveTree;
+    CompactMoveTree _moveTree;
     Mutex _moveTreeMutex;
     // The leaf nodes waiting to grow new branches.  
-    ShareableIndexedPriorityQueue<unsigned, MoveNode, 512> _fringe;
+    // Fringe leaves are indexed by their minimum move counts 
+    // (offset from _initialMinMoves) and, if the tie-breaking policy
+    // or focal search calls for it, their minimum moves left 
+    // (see FringeIndex()).  Minimum move counts too high for the
+    // last row share it, so the minimum move count MinMoves() gives
+    // for a leaf there is only a lower bound.  With minimum moves
+    // left, there are FringeIndices/HLevels rows, enough for move
+    // counts 512 above the deal's, well past any solution found.
+    static constexpr unsigned FringeIndices = 64*1024;
+    static constexpr unsigned HLevels = 128;
+    ShareableIndexedPriorityQueue<unsigned, MoveNode, FringeIndices> _fringe;
     unsigned _initialMinMoves {-1U};
+    bool _byMovesLeft {false};      // index by minimum moves left too
+    double _focalFactor {1.0};      // see PopFocal()
+    // Returns the fringe index for a leaf
+    unsigned FringeIndex(unsigned minMoves, unsigned minMovesLeft) const noexcept
+    {
+        assert(_initialMinMoves <= minMoves);
+        const unsigned offset = minMoves - _initialMinMoves;
+        if (!_byMovesLeft)
+            return std::min(offset, FringeIndices-1);
+        return std::min(offset, FringeIndices/HLevels-1)*HLevels 
+             + std::min(minMovesLeft, HLevels-1);
+    }
+    // Returns the minimum move count of a leaf with the given fringe index
+    unsigned MinMoves(unsigned fringeIndex) const noexcept
+    {
+        return _initialMinMoves + 
+            (_byMovesLeft ? fringeIndex/HLevels : fringeIndex);
+    }
     bool _firstTime;
+
+    // Garbage collection of move tree nodes no fringe leaf leads back to.
+    // Each worker is busy from the time it pops a leaf from the fringe
+    // until it next tries to pop one.  Collection happens only
+    // when no worker is busy.
+    Mutex _gcMutex;
+    std::condition_variable _gcCondition;
+    unsigned _busyWorkers {0};
+    bool _gcPending {false};
+    size_t _gcThreshold;            // collect when the move tree is this big
+    unsigned _gcCount {0};
+    // Wait for any collection to finish, then count the caller as busy.
+    void BeginWork() noexcept;
+    // Count the caller as no longer busy.
+    void EndWork() noexcept;
+    // If the move tree has grown past _gcThreshold, wait until no other 
+    // worker is busy and remove all unreachable nodes from the move tree.
+    // The caller must not be busy.
+    void CollectGarbageIfNeeded() noexcept;
+    void CollectGarbage() noexcept;
+    // Focal search.  Let fMin be the lowest minimum move count of any
+    // leaf in the fringe.  Pop a leaf with the fewest minimum moves 
+    // left among those whose minimum move counts are no more than
+    // _focalFactor*fMin and less than bound.  Sets fringeMin to fMin.
+    std::optional<std::pair<unsigned,MoveNode>> 
+        PopFocal(unsigned bound, unsigned& fringeMin) noexcept;
     friend class MoveStorage;
 public:
-    void Start(size_t moveTreeSizeLimit, unsigned minMoves) noexcept;
+    // A focalFactor w above 1 calls for focal search (see PopFocal()).
+    void Start(size_t moveTreeSizeLimit, unsigned minMoves, 
+               TieBreak tieBreak, double focalFactor) noexcept;
+    // Let the fringe move leaves far from the front of the queue
+    // to a temporary file.
+    void EnableFringeSpill() noexcept 
+    {
+        _fringe.EnableSpill(FringeIndex(_initialMinMoves+3,0));
+    }
 
-    unsigned FringeSize() const noexcept{
+    // Drop all fringe leaves whose minimum move counts are
+    // moveCount or more.  Call this when a solution of moveCount
+    // moves has been found.  The shared last row (see FringeIndices)
+    // may hold leaves with lower minimum move counts, so it is never
+    // dropped by itself.
+    void DropFringeAtOrAbove(unsigned moveCount) noexcept{
+        if (moveCount <= _initialMinMoves) return;
+        const unsigned index = FringeIndex(moveCount,0);
+        if (MinMoves(index) == moveCount)
+            _fringe.Truncate(index);
+    }
+    size_t FringeSize() const noexcept{
         return _fringe.Size();
     }
-    unsigned MoveTreeSize() const noexcept{
-        return _moveTree.size();
+    // Returns the number of nodes in the move tree
+    size_t MoveTreeSize() const noexcept{
+        return _moveTree.Size();
+    }
+    // Returns the number of 4-byte cells the move tree occupies
+    size_t MoveTreeCells() const noexcept{
+        return _moveTree.CellCount();
+    }
+    // Returns the number of garbage collections done
+    unsigned GarbageCollections() const noexcept{
+        return _gcCount;
     }
+    // Returns true if the move tree has outgrown its limit or if
+    // fringe leaves spilled to disk have been lost.  Either way, the
+    // search cannot be complete.
     bool OverLimit() const noexcept{
-        return _moveTree.size() > _moveTreeSizeLimit;
+        return _moveTree.Size() > _moveTreeSizeLimit || _fringe.SpillFailed();
     }
 };
 
@@ -127,21 +510,28 @@ class MoveStorage
 {
 public:
     MoveStorage(SharedMoveStorage& shared) noexcept;
+    ~MoveStorage() noexcept;
     // Return a reference to the storage shared among threads
     SharedMoveStorage& Shared() const noexcept {return _shared;}
     // Push a move to the back of the current stem.
     void PushStem(MoveSpec move) noexcept;
     // Push the first move of a new branch off the current stem,
     // along with the heuristic value associated with that move,
-    // i.e. its the minimum move count.
-    void PushBranch(MoveSpec move, unsigned moveCount) noexcept;
+    // i.e. its the minimum move count, and the minimum moves left
+    // after it.
+    void PushBranch(MoveSpec move, unsigned moveCount, unsigned movesLeft) noexcept;
     // Push all the moves (stem and branch) from this trip
-    // through the main loop into shared storage.
-    void ShareMoves() noexcept;
+    // through the main loop into shared storage, except branches
+    // whose minimum move counts are bound or more.
+    void ShareMoves(unsigned bound = -1U) noexcept;
     // Identify a move sequence with the lowest available minimum move count, 
     // return its minimum move count or, if no more sequences are available.
     // return 0. Remove that sequence from the open queue and make it current.
-    unsigned PopNextMoveSequence() noexcept;
+    // In focal search, choose one as PopFocal() does instead.
+    unsigned PopNextMoveSequence(unsigned bound = -1U) noexcept;
+    // Return the lowest minimum move count in the fringe seen by the 
+    // last call to PopNextMoveSequence().  No solution can be shorter.
+    unsigned FringeMinMoves() const noexcept {return _fringeMinMoves;}
     // Copy the moves in the current sequence from the move tree.
     void LoadMoveSequence() noexcept; 
     // Make all the moves in the current sequence
@@ -155,13 +545,15 @@ private:
     MoveSequenceType _currentSequence;
     MoveNode _leaf{};	    // current sequence's starting leaf node 
     unsigned _startSize{0}; // number of MoveSpecs gotten from the move tree.
+    unsigned _fringeMinMoves{0};    // see FringeMinMoves()
+    bool _busy{false};      // see SharedMoveStorage::BeginWork()
     struct MovePair
     {
         MoveSpec _mv;
-        std::uint32_t _offset;
-        MovePair(MoveSpec mv, unsigned offset)
+        std::uint32_t _index;   // fringe index
+        MovePair(MoveSpec mv, unsigned index)
             : _mv(mv)
-            , _offset(offset)
+            , _index(index)
         {}
     };
     static_vector<MovePair,32> _branches;
@@ -0,0 +1,70 @@
+// SolverOptions.hpp declares the enumerations that choose how
+// KSolveAStar() stores what it has seen and what it will look at
+// next.  They are here rather than in KSolveAStar.hpp so that the
+// storage classes can use them without depending on the solver.
+
+#ifndef SOLVEROPTIONS_HPP
+#define SOLVEROPTIONS_HPP
+
+namespace KSolveNames {
+
+// The kinds of closed list (the memory of game states visited) available.
+// ExactClosedList stores each game state in full.  LossyClosedList
+// stores only a 49-bit fingerprint of each, using about half the memory.
+// A fingerprint collision can cause the solver to skip a state it has
+// never seen, so with LossyClosedList, KSolveAStar() never reports
+// SolvedMinimal or Impossible.  Solved and GaveUp take their places.
+//
+// The other kinds are exact alternatives to the default ExactClosedList,
+// which is a parallel_flat_hash_set with 256 submaps each guarded by
+// a std::mutex.  They are:
+//  SpinLockClosedList      the same with spin locks
+//  SharedMutexClosedList   the same with std::shared_mutex locks; looks
+//                          that change nothing take a shared lock
+//  TunedClosedList         the same with about 16 submaps per thread
+//  ShardedStdClosedList    256 std::unordered_set shards with std::mutex
+//                          locks, for comparison
+//  LockFreeClosedList      a fixed-size open-addressing table updated
+//                          by compare-and-swap, with no locks. Its size
+//                          is set from MoveTreeLimit, and it is
+//                          allocated in full at the start.
+//  ExternalClosedList      external-memory mode. The closed list keeps
+//                          its 16M newest states in main memory and 
+//                          moves older ones to sorted temporary files.
+//                          The fringe moves leaves whose minimum move
+//                          counts are well above the current minimum
+//                          to a temporary file in batches. Main memory
+//                          use grows much more slowly, at some cost
+//                          in speed.
+//  FrontierClosedList      the same as ExactClosedList, except that it
+//                          forgets states reached by 32 or more fewer
+//                          moves than the longest path seen.  Memory
+//                          use follows the width of the search 
+//                          frontier rather than its whole interior,
+//                          at the cost of some states being expanded
+//                          more than once.  Cycles through forgotten
+//                          states go undetected, so a search of a deal
+//                          that cannot be won may give up instead of
+//                          proving it impossible.
+enum ClosedListKind {
+    ExactClosedList, 
+    LossyClosedList,
+    SpinLockClosedList,
+    SharedMutexClosedList,
+    TunedClosedList,
+    ShardedStdClosedList,
+    LockFreeClosedList,
+    ExternalClosedList,
+    FrontierClosedList
+};
+// How to choose among fringe leaves with equal minimum move counts.
+//  LifoTieBreak    the one pushed most recently
+//  LowHTieBreak    the one with the fewest minimum moves left (by
+//                  MinimumMovesLeft()), which is the one with the
+//                  most moves made.  Among those, the one pushed
+//                  most recently.
+enum TieBreak {LifoTieBreak, LowHTieBreak};
+
+}       // namespace KSolveNames
+
+#endif    // SOLVEROPTIONS_HPP
@@ -0,0 +1,78 @@
+// A SpillFile is an anonymous temporary file to which a container
+// can move some of its contents to save main memory.  The file
+// is deleted when the object is destroyed.
+//
+// Instances are thread-safe.
+
+#ifndef SPILLFILE_HPP
+#define SPILLFILE_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+namespace KSolveNames {
+
+class SpillFile
+{
+    std::FILE* _file;
+    std::mutex _mutex;
+    std::uint64_t _size{0};
+
+    bool SeekTo(std::uint64_t offset) noexcept
+    {
+#ifdef _MSC_VER
+        return _fseeki64(_file, offset, SEEK_SET) == 0;
+#else
+        return fseeko(_file, offset, SEEK_SET) == 0;
+#endif
+    }
+public:
+    SpillFile() noexcept
+        : _file(std::tmpfile())
+        {}
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+    ~SpillFile() noexcept
+    {
+        if (_file) std::fclose(_file);
+    }
+    // Returns false if the file could not be created.
+    bool IsOpen() const noexcept {return _file != nullptr;}
+    // Returns the number of bytes written so far.
+    std::uint64_t Size() const noexcept {return _size;}
+    // Write n bytes at the end of the file and set offset to where
+    // they start.  Returns false if they could not all be written, as
+    // when the disk is full.  Size() is then unchanged.
+    [[nodiscard]] bool Append(const void* data, size_t n, std::uint64_t& offset) noexcept
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        offset = _size;
+        if (!SeekTo(offset) || std::fwrite(data, 1, n, _file) != n
+                || std::fflush(_file) != 0)
+            return false;
+        _size += n;
+        return true;
+    }
+    // Replace n bytes starting at offset, which must be no
+    // more than Size()-n.  Returns false on failure.
+    [[nodiscard]] bool Overwrite(std::uint64_t offset, const void* data, size_t n) noexcept
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        assert(offset + n <= _size);
+        return SeekTo(offset) && std::fwrite(data, 1, n, _file) == n
+            && std::fflush(_file) == 0;
+    }
+    // Read n bytes starting at offset.  Returns false if they could
+    // not all be read.
+    [[nodiscard]] bool Read(std::uint64_t offset, void* data, size_t n) noexcept
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return SeekTo(offset) && std::fread(data, 1, n, _file) == n;
+    }
+};
+
+}   // namespace KSolveNames
+
+#endif      // SPILLFILE_HPP
@@ -0,0 +1,83 @@
+// BeamTriage sorts a range of numbered deals with KSolveBeam() and
+// passes those it cannot settle to KSolveAStar().  It tries
+// KSolveNRPA() on those for which KSolveAStar() gives up.  It reports
+// the beam statistics for each deal and the time taken by each stage.
+//
+// Usage: BeamTriage [draw [deals [firstDeal [width [threads [moveTreeLimit]]]]]]
+
+#include "KSolveBeam.hpp"
+#include "KSolveAStar.hpp"
+#include "KSolveNRPA.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace KSolveNames;
+
+int main(int argc, char* argv[])
+{
+    const unsigned draw = argc > 1 ? std::atoi(argv[1]) : 1;
+    const unsigned nDeals = argc > 2 ? std::atoi(argv[2]) : 10;
+    const unsigned firstDeal = argc > 3 ? std::atoi(argv[3]) : 1;
+    const unsigned width = argc > 4 ? std::atoi(argv[4]) : 1000;
+    const unsigned nThreads = argc > 5 ? std::atoi(argv[5]) : 0;
+    const size_t moveTreeLimit = argc > 6 ? std::atoll(argv[6]) : 12'000'000;
+
+    std::vector<unsigned> unsettled;
+    unsigned nSolved = 0, nImpossible = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned deal = firstDeal; deal < firstDeal+nDeals; ++deal) {
+        Game game(NumberedDeal(deal), draw);
+        const auto result = KSolveBeam(game, width);
+        if (result._code == Solved) TestSolution(game, result._solution);
+        nSolved += result._code == Solved;
+        nImpossible += result._code == Impossible;
+        if (result._code == GaveUp) unsettled.push_back(deal);
+        std::cout << "beam deal " << deal 
+            << " code " << result._code
+            << " moves " << MoveCount(result._solution)
+            << " depth " << result._depth
+            << " expansions " << result._expansionCount
+            << " children " << result._childCount
+            << " duplicates " << result._duplicateCount
+            << " dropped " << result._droppedCount
+            << " max beam " << result._maxBeamSize << "\n";
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "beam: " << nSolved << " solved, " 
+        << nImpossible << " impossible, "
+        << unsettled.size() << " unsettled, " 
+        << elapsed.count() << " s\n";
+
+    std::vector<unsigned> givenUp;
+    start = std::chrono::steady_clock::now();
+    for (unsigned deal: unsettled) {
+        Game game(NumberedDeal(deal), draw);
+        const auto result = KSolveAStar(game, moveTreeLimit, nThreads);
+        if (result._code == GaveUp) givenUp.push_back(deal);
+        std::cout << "A* deal " << deal 
+            << " code " << result._code
+            << " moves " << MoveCount(result._solution) << "\n";
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "A*: " << unsettled.size() << " deals, " 
+        << givenUp.size() << " given up, "
+        << elapsed.count() << " s\n";
+
+    start = std::chrono::steady_clock::now();
+    for (unsigned deal: givenUp) {
+        Game game(NumberedDeal(deal), draw);
+        const auto result = KSolveNRPA(game, deal, nThreads);
+        if (result._code == Solved) TestSolution(game, result._solution);
+        std::cout << "NRPA deal " << deal 
+            << " code " << result._code
+            << " moves " << MoveCount(result._solution)
+            << " rollouts " << result._rolloutCount << "\n";
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "NRPA: " << givenUp.size() << " deals, " 
+        << elapsed.count() << " s\n";
+    return 0;
+}
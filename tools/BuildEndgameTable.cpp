@@ -0,0 +1,57 @@
+// BuildEndgameTable solves a range of numbered deals with an
+// EndgameTable attached and saves what the table learned to a file.
+// If the file exists, the table starts with its contents, so runs
+// over different ranges of deals add to the same file.  The solver
+// can then start from the file (see EndgameTable::Load()).
+//
+// Usage: BuildEndgameTable file [draw [deals [firstDeal [maxCards [threads [moveTreeLimit]]]]]]
+
+#include "KSolveAStar.hpp"
+#include "EndgameTable.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace KSolveNames;
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: BuildEndgameTable file [draw [deals [firstDeal "
+                     "[maxCards [threads [moveTreeLimit]]]]]]\n";
+        return 1;
+    }
+    const std::string path = argv[1];
+    const unsigned draw = argc > 2 ? std::atoi(argv[2]) : 1;
+    const unsigned nDeals = argc > 3 ? std::atoi(argv[3]) : 10;
+    const unsigned firstDeal = argc > 4 ? std::atoi(argv[4]) : 1;
+    const unsigned maxCards = argc > 5 ? std::atoi(argv[5]) : EndgameTable::MaxCardsLimit;
+    const unsigned nThreads = argc > 6 ? std::atoi(argv[6]) : 0;
+    const size_t moveTreeLimit = argc > 7 ? std::atoll(argv[7]) : 12'000'000;
+
+    EndgameTable table(maxCards);
+    if (table.Load(path))
+        std::cout << "Loaded " << table.Size() << " positions from " << path << "\n";
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned deal = firstDeal; deal < firstDeal+nDeals; ++deal) {
+        Game game(NumberedDeal(deal), draw);
+        const auto result = KSolveAStar(game, moveTreeLimit, nThreads, 
+            ExactClosedList, LifoTieBreak, false, 1.0, false, &table);
+        std::cout << "deal " << deal 
+            << " code " << result._code
+            << " moves " << MoveCount(result._solution)
+            << " expansions " << result._expansionCount
+            << " positions " << table.Size() << "\n";
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << elapsed.count() << " s\n";
+
+    if (!table.Save(path)) {
+        std::cerr << "Cannot write " << path << "\n";
+        return 1;
+    }
+    std::cout << "Saved " << table.Size() << " positions to " << path << "\n";
+    return 0;
+}
@@ -0,0 +1,136 @@
+// ClosedListBench compares the closed list implementations selectable
+// by ClosedListKind on probe traces recorded from real game trees.
+//
+// Usage: ClosedListBench [draw [deals [threads [probesPerDeal]]]]
+//
+// For each of the deals numbered 1 through deals, it explores the game
+// depth first, recording every {GameState, move count} probe it makes
+// of a closed list, until probesPerDeal probes have been recorded.
+// It then replays the whole trace against each kind of closed list,
+// with the probes dealt out among threads threads in interleaved
+// chunks, and reports the time per probe.
+
+#include "GameStateMemory.hpp"
+#include "KSolveAStar.hpp"          // for DefaultThreads
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace KSolveNames;
+
+using Trace = std::vector<GameState>;
+
+// Explore a game depth first, recording a probe for every child position.
+class Recorder
+{
+    Game _game;
+    Trace& _trace;
+    GameStateMemory _closed;
+    size_t _limit;
+    std::vector<MoveSpec> _moves;
+    unsigned _moveCount{0};
+
+    void Push(MoveSpec mv)
+    {
+        _game.MakeMove(mv);
+        _moves.push_back(mv);
+        _moveCount += mv.NMoves();
+    }
+    void Pop()
+    {
+        _moveCount -= _moves.back().NMoves();
+        _game.UnMakeMove(_moves.back());
+        _moves.pop_back();
+    }
+    void Explore()
+    {
+        // Make the forced moves.
+        const size_t depth = _moves.size();
+        QMoves avail;
+        while ((avail = _game.AvailableMoves(_moves)).size() == 1)
+            Push(avail[0]);
+        for (auto mv: avail) {
+            if (_trace.size() >= _limit) break;
+            Push(mv);
+            const GameState probe{_game, _moveCount};
+            _trace.push_back(probe);
+            if (_closed.IsShortPathToState(probe))
+                Explore();
+            Pop();
+        }
+        while (_moves.size() > depth)
+            Pop();
+    }
+public:
+    Recorder(const Game& game, Trace& trace, size_t nProbes)
+        : _game(game)
+        , _trace(trace)
+        , _closed(ExactClosedList, 1)
+        , _limit(trace.size() + nProbes)
+    {}
+    void Run()
+    {
+        _game.Deal();
+        Explore();
+    }
+};
+
+static double Replay(ClosedListKind kind, const Trace& trace, unsigned nThreads)
+{
+    GameStateMemory closed(kind, nThreads, trace.size());
+    const size_t chunk = 1024;
+    auto worker = [&](unsigned t) {
+        for (size_t begin = t*chunk; begin < trace.size(); begin += nThreads*chunk) {
+            const size_t end = std::min(begin+chunk, trace.size());
+            for (size_t i = begin; i < end; ++i)
+                closed.IsShortPathToState(trace[i]);
+        }
+    };
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nThreads; ++t)
+        threads.emplace_back(worker, t);
+    worker(0);
+    for (auto& thread: threads)
+        thread.join();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << " (" << closed.Size() << " states) ";
+    return elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned draw = argc > 1 ? std::atoi(argv[1]) : 1;
+    const unsigned nDeals = argc > 2 ? std::atoi(argv[2]) : 10;
+    unsigned nThreads = argc > 3 ? std::atoi(argv[3]) : 0;
+    const size_t probesPerDeal = argc > 4 ? std::atoll(argv[4]) : 500'000;
+    if (nThreads == 0) nThreads = DefaultThreads();
+
+    Trace trace;
+    trace.reserve(nDeals*probesPerDeal);
+    for (unsigned deal = 1; deal <= nDeals; ++deal) {
+        Game game(NumberedDeal(deal), draw);
+        Recorder(game, trace, probesPerDeal).Run();
+    }
+    std::cout << trace.size() << " probes, " << nThreads << " threads\n";
+
+    const std::pair<ClosedListKind, const char*> kinds[] {
+        {ExactClosedList,       "ExactClosedList"},
+        {LossyClosedList,       "LossyClosedList"},
+        {SpinLockClosedList,    "SpinLockClosedList"},
+        {SharedMutexClosedList, "SharedMutexClosedList"},
+        {TunedClosedList,       "TunedClosedList"},
+        {ShardedStdClosedList,  "ShardedStdClosedList"},
+        {LockFreeClosedList,    "LockFreeClosedList"},
+        {FrontierClosedList,    "FrontierClosedList"},
+    };
+    for (auto [kind, name]: kinds) {
+        std::cout << name;
+        const double seconds = Replay(kind, trace, nThreads);
+        std::cout << seconds*1e9/trace.size() << " ns/probe\n";
+    }
+    return 0;
+}
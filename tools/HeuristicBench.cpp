@@ -0,0 +1,79 @@
+// HeuristicBench measures MinimumMovesLeft() over a range of numbered
+// deals.  It checks consistency by random walks from each deal: for
+// every move offered along the way, the moves left before the move
+// must not exceed the moves the move makes plus the moves left after
+// it.  Then it solves each deal with KSolveAStar() and reports the
+// bound at the deal, the moves in the solution, and the leaves
+// expanded, with totals for the range.
+//
+// Usage: HeuristicBench [draw [deals [firstDeal [walks [threads [moveTreeLimit]]]]]]
+
+#include "KSolveAStar.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace KSolveNames;
+
+// Take walks random walks from game, each until no moves are left
+// or 300 moves have been made.  Returns the number of moves found
+// to violate consistency.
+static unsigned CheckConsistency(const Game& deal, unsigned walks, unsigned seed)
+{
+    std::mt19937_64 rng(seed);
+    unsigned violations = 0;
+    for (unsigned walk = 0; walk < walks; ++walk) {
+        Game game(deal);
+        MoveCounter<Moves> moves;
+        moves.clear();
+        QMoves avail;
+        while ((avail = game.AvailableMoves(moves)).size() && moves.MoveCount() < 300) {
+            const unsigned before = MinimumMovesLeft(game);
+            for (auto mv: avail) {
+                game.MakeMove(mv);
+                violations += before > mv.NMoves() + MinimumMovesLeft(game);
+                game.UnMakeMove(mv);
+            }
+            const auto mv = avail[rng() % avail.size()];
+            game.MakeMove(mv);
+            moves.push_back(mv);
+        }
+    }
+    return violations;
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned draw = argc > 1 ? std::atoi(argv[1]) : 3;
+    const unsigned nDeals = argc > 2 ? std::atoi(argv[2]) : 10;
+    const unsigned firstDeal = argc > 3 ? std::atoi(argv[3]) : 1;
+    const unsigned walks = argc > 4 ? std::atoi(argv[4]) : 100;
+    const unsigned nThreads = argc > 5 ? std::atoi(argv[5]) : 0;
+    const size_t moveTreeLimit = argc > 6 ? std::atoll(argv[6]) : 12'000'000;
+
+    size_t totalExpansions = 0;
+    unsigned nSolved = 0, nViolations = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned deal = firstDeal; deal < firstDeal+nDeals; ++deal) {
+        Game game(NumberedDeal(deal), draw);
+        const unsigned violations = CheckConsistency(game, walks, deal);
+        const auto result = KSolveAStar(game, moveTreeLimit, nThreads);
+        totalExpansions += result._expansionCount;
+        nSolved += result._code == SolvedMinimal;
+        nViolations += violations;
+        std::cout << "deal " << deal
+            << " bound " << MinimumMovesLeft(game)
+            << " violations " << violations
+            << " code " << result._code
+            << " moves " << MoveCount(result._solution)
+            << " expansions " << result._expansionCount << "\n";
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << nSolved << " solved minimal, "
+        << nViolations << " violations, "
+        << totalExpansions << " expansions, "
+        << elapsed.count() << " s\n";
+    return 0;
+}
@@ -0,0 +1,47 @@
+// SolveBench solves a range of numbered deals with each fringe
+// tie-breaking policy and reports the leaves expanded and time taken.
+//
+// Usage: SolveBench [draw [deals [firstDeal [threads [moveTreeLimit]]]]]
+
+#include "KSolveAStar.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace KSolveNames;
+
+int main(int argc, char* argv[])
+{
+    const unsigned draw = argc > 1 ? std::atoi(argv[1]) : 1;
+    const unsigned nDeals = argc > 2 ? std::atoi(argv[2]) : 10;
+    const unsigned firstDeal = argc > 3 ? std::atoi(argv[3]) : 1;
+    const unsigned nThreads = argc > 4 ? std::atoi(argv[4]) : 0;
+    const size_t moveTreeLimit = argc > 5 ? std::atoll(argv[5]) : 12'000'000;
+
+    const std::pair<TieBreak, const char*> policies[] {
+        {LifoTieBreak,  "LifoTieBreak"},
+        {LowHTieBreak,  "LowHTieBreak"},
+    };
+    for (auto [policy, name]: policies) {
+        size_t totalExpansions = 0;
+        unsigned nSolved = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned deal = firstDeal; deal < firstDeal+nDeals; ++deal) {
+            Game game(NumberedDeal(deal), draw);
+            const auto result = KSolveAStar(game, moveTreeLimit, nThreads, 
+                                            ExactClosedList, policy);
+            totalExpansions += result._expansionCount;
+            nSolved += result._code == SolvedMinimal;
+            std::cout << name << " deal " << deal 
+                << " code " << result._code
+                << " moves " << MoveCount(result._solution)
+                << " expansions " << result._expansionCount << "\n";
+        }
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << nSolved << " solved minimal, " 
+            << totalExpansions << " expansions, " 
+            << elapsed.count() << " s\n";
+    }
+    return 0;
+}